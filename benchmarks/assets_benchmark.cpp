@@ -0,0 +1,129 @@
+#include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/assets.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <mutex>
+
+// Every reader thread checks and reads each mesh like the render loop does, while one more thread keeps
+// requesting new meshes. Compares the asset table against a table guarded by a single mutex.
+// Usage: AssetsBenchmark [readers]
+
+constexpr auto mesh_count = 4096u;
+constexpr auto passes = 256u;
+constexpr auto emplaced_during_run = 65536u;
+
+// The table the asset registry replaced: every access takes the same lock.
+namespace locked {
+    struct InternalStorage {
+        qz::gfx::StaticMesh object;
+        bool done;
+    };
+
+    static std::vector<InternalStorage> assets;
+    static std::mutex done_mutex;
+
+    static std::uint32_t emplace_empty() noexcept {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        assets.emplace_back();
+        return assets.size() - 1;
+    }
+
+    static qz::gfx::StaticMesh& from_handle(const std::uint32_t index) noexcept {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        return assets[index].object;
+    }
+
+    static void finalize(const std::uint32_t index) noexcept {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        assets[index].done = true;
+    }
+
+    static bool is_ready(const std::uint32_t index) noexcept {
+        std::lock_guard<std::mutex> lock(done_mutex);
+        return assets[index].done;
+    }
+} // namespace locked
+
+template <typename Read, typename Emplace>
+static double run(const std::uint32_t readers, Read&& read, Emplace&& emplace) noexcept {
+    std::atomic<bool> start = false;
+    std::atomic<std::uint64_t> checksum = 0;
+    std::vector<std::thread> threads;
+    for (std::uint32_t i = 0; i < readers; ++i) {
+        threads.emplace_back([&]() noexcept {
+            while (!start.load(std::memory_order_acquire));
+            std::uint64_t sum = 0;
+            for (std::uint32_t pass = 0; pass < passes; ++pass) {
+                for (std::uint32_t mesh = 0; mesh < mesh_count; ++mesh) {
+                    sum += read(mesh);
+                }
+            }
+            checksum += sum;
+        });
+    }
+    threads.emplace_back([&]() noexcept {
+        while (!start.load(std::memory_order_acquire));
+        for (std::uint32_t i = 0; i < emplaced_during_run; ++i) {
+            emplace();
+        }
+    });
+
+    const auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (auto& each : threads) {
+        each.join();
+    }
+    const auto end = std::chrono::steady_clock::now();
+    const auto lookups = static_cast<double>(readers) * passes * mesh_count;
+    std::printf("    checksum %llu\n", static_cast<unsigned long long>(checksum.load()));
+    return std::chrono::duration<double, std::nano>(end - begin).count() / lookups;
+}
+
+int main(int argc, char** argv) {
+    using namespace qz;
+
+    const auto readers = argc > 1 ?
+        static_cast<std::uint32_t>(std::atoi(argv[1])) :
+        std::max(std::thread::hardware_concurrency() - 1, 1u);
+
+    std::vector<meta::Handle<gfx::StaticMesh>> handles;
+    // Reserved up front, the locked table hands out references a reallocation would invalidate.
+    locked::assets.reserve(mesh_count + emplaced_during_run);
+    for (std::uint32_t i = 0; i < mesh_count; ++i) {
+        const auto handle = assets::emplace_empty<gfx::StaticMesh>();
+        assets::from_handle(handle).vertex_offset = i;
+        assets::finalize(handle);
+        handles.emplace_back(handle);
+
+        const auto index = locked::emplace_empty();
+        locked::from_handle(index).vertex_offset = i;
+        locked::finalize(index);
+    }
+
+    std::printf("%u readers, %u meshes, %u passes\n", readers, mesh_count, passes);
+    std::printf("Mutex guarded table:\n");
+    const auto locked_time = run(readers, [](const std::uint32_t index) noexcept -> std::uint32_t {
+        return locked::is_ready(index) ? locked::from_handle(index).vertex_offset : 0;
+    }, []() noexcept {
+        (void)locked::emplace_empty();
+    });
+    std::printf("    %.2f ns per lookup\n", locked_time);
+
+    std::printf("Asset table:\n");
+    const auto table_time = run(readers, [&handles](const std::uint32_t index) noexcept -> std::uint32_t {
+        const auto handle = handles[index];
+        return assets::is_ready(handle) ? assets::from_handle(handle).vertex_offset : 0;
+    }, []() noexcept {
+        (void)assets::emplace_empty<gfx::StaticMesh>();
+    });
+    std::printf("    %.2f ns per lookup\n", table_time);
+    std::printf("Speedup: %.1fx\n", locked_time / table_time);
+    return 0;
+}
\ No newline at end of file
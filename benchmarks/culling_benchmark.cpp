@@ -0,0 +1,85 @@
+#include <qz/gfx/culling.hpp>
+
+#include <qz/task/scheduler.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <cmath>
+
+// Culls a field of randomly placed instances against a perspective frustum looking down -z, on the same
+// scheduler the engine uses. Reports the average and best time of a frame's cull_instances call.
+// Usage: CullingBenchmark [instances] [iterations]
+
+constexpr auto target_milliseconds = 1.0;
+
+int main(int argc, char** argv) {
+    using namespace qz;
+
+    const auto count = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 100000u;
+    const auto iterations = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 1000u;
+
+    // Culling needs nothing from Vulkan, only the task scheduler is started.
+    task::get_scheduler().Init({
+        .Behavior = ftl::EmptyQueueBehavior::Sleep
+    });
+
+    // Column major, 60 degrees vertical field of view, 16:9, depth from 0.1 to 1000 mapped to [0, 1].
+    constexpr auto near = 0.1f;
+    constexpr auto far = 1000.0f;
+    const auto focal = 1.0f / std::tan(3.14159265f / 6.0f);
+    const float projection[] = {
+        focal / (16.0f / 9.0f), 0.0f, 0.0f, 0.0f,
+        0.0f, focal, 0.0f, 0.0f,
+        0.0f, 0.0f, far / (near - far), -1.0f,
+        0.0f, 0.0f, near * far / (near - far), 0.0f
+    };
+    const auto frustum = gfx::Frustum::from_matrix(projection);
+
+    // Instances are spread in front of and behind the camera so a good share of them is culled.
+    gfx::InstanceBounds bounds;
+    std::uint32_t state = 12345;
+    const auto random = [&state](const float min, const float max) noexcept {
+        state = state * 1664525u + 1013904223u;
+        return min + (max - min) * static_cast<float>(state >> 8) / static_cast<float>(1u << 24);
+    };
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const auto extent = random(0.5f, 4.0f);
+        const auto center = std::array<float, 3>{ random(-600.0f, 600.0f), random(-600.0f, 600.0f), random(-1100.0f, 100.0f) };
+        gfx::MeshBounds mesh{};
+        for (std::uint32_t axis = 0; axis < 3; ++axis) {
+            mesh.min[axis] = center[axis] - extent;
+            mesh.max[axis] = center[axis] + extent;
+            mesh.center[axis] = center[axis];
+        }
+        mesh.radius = extent * std::sqrt(3.0f);
+        bounds.push_back(mesh);
+    }
+
+    std::vector<std::uint32_t> visible;
+    // Warms up the workers and the output's allocation.
+    for (std::uint32_t i = 0; i < 16; ++i) {
+        gfx::cull_instances(frustum, bounds, visible);
+    }
+
+    auto total = 0.0;
+    auto best = 1e9;
+    for (std::uint32_t i = 0; i < iterations; ++i) {
+        const auto begin = std::chrono::steady_clock::now();
+        gfx::cull_instances(frustum, bounds, visible);
+        const auto end = std::chrono::steady_clock::now();
+        const auto milliseconds = std::chrono::duration<double, std::milli>(end - begin).count();
+        total += milliseconds;
+        best = std::min(best, milliseconds);
+    }
+
+    const auto average = total / iterations;
+    std::printf("%u instances, %zu visible, %zu threads\n", count, visible.size(), static_cast<std::size_t>(task::get_scheduler().GetThreadCount()));
+    std::printf("Average %.3f ms, best %.3f ms, target %.1f ms: %s\n",
+        average, best, target_milliseconds, average < target_milliseconds ? "met" : "missed");
+    return 0;
+}
\ No newline at end of file
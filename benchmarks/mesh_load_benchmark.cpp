@@ -0,0 +1,167 @@
+#include <qz/gfx/mesh_optimizer.hpp>
+#include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/gfx/renderer.hpp>
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/context.hpp>
+#include <qz/gfx/window.hpp>
+#include <qz/gfx/assets.hpp>
+#include <qz/gfx/upload.hpp>
+
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+// Uploads the same grid mesh a number of times from a .qzm file and from in-memory vertices, timing each until
+// every mesh is ready. The file is written next to the executable and removed afterwards.
+// Usage: MeshLoadBenchmark [meshes] [grid size]
+
+constexpr auto file_path = "mesh_load_benchmark.qzm";
+
+struct Grid {
+    std::vector<float> vertices;
+    std::vector<std::uint32_t> indices;
+    std::vector<qz::gfx::VertexAttribute> attributes;
+};
+
+static Grid make_grid(const std::uint32_t size) noexcept {
+    Grid grid;
+    grid.attributes = { qz::gfx::VertexAttribute::vec3, qz::gfx::VertexAttribute::unorm8x4 };
+    for (std::uint32_t y = 0; y < size; ++y) {
+        for (std::uint32_t x = 0; x < size; ++x) {
+            const auto u = static_cast<float>(x) / (size - 1);
+            const auto v = static_cast<float>(y) / (size - 1);
+            grid.vertices.insert(grid.vertices.end(), { u * 2 - 1, v * 2 - 1, 0.0f, u, v, 1.0f, 1.0f });
+        }
+    }
+    for (std::uint32_t y = 0; y + 1 < size; ++y) {
+        for (std::uint32_t x = 0; x + 1 < size; ++x) {
+            const auto corner = y * size + x;
+            grid.indices.insert(grid.indices.end(), {
+                corner, corner + 1, corner + size,
+                corner + 1, corner + size + 1, corner + size
+            });
+        }
+    }
+    return grid;
+}
+
+static std::size_t write_mesh_file(const Grid& grid) noexcept {
+    using namespace qz;
+
+    gfx::MeshFileHeader header{};
+    header.magic = gfx::mesh_file_magic;
+    header.version = gfx::mesh_file_version;
+    for (const auto each : grid.attributes) {
+        header.attributes[header.attribute_count++] = static_cast<std::uint32_t>(each);
+    }
+    const auto components = gfx::vertex_components(grid.attributes);
+    header.index_size = sizeof(std::uint32_t);
+    header.vertex_count = grid.vertices.size() / components;
+    header.index_count = grid.indices.size();
+    header.lod_count = 1;
+    header.lods[0] = { 0, header.index_count, 0.0f };
+    header.bounds = gfx::compute_bounds(grid.vertices, components);
+
+    const auto align = [](const std::uint64_t value) noexcept {
+        return (value + gfx::mesh_file_alignment - 1) & ~(gfx::mesh_file_alignment - 1);
+    };
+    const auto vertices_size = static_cast<std::size_t>(header.vertex_count) * gfx::vertex_stride(grid.attributes);
+    const auto indices_size = grid.indices.size() * sizeof(std::uint32_t);
+    header.vertex_offset = align(sizeof header);
+    header.index_offset = align(header.vertex_offset + vertices_size);
+
+    std::vector<char> file(header.index_offset + indices_size);
+    std::memcpy(file.data(), &header, sizeof header);
+    gfx::pack_vertices(grid.vertices, grid.attributes, file.data() + header.vertex_offset);
+    std::memcpy(file.data() + header.index_offset, grid.indices.data(), indices_size);
+
+    auto output = std::fopen(file_path, "wb");
+    if (!output || std::fwrite(file.data(), 1, file.size(), output) != file.size()) {
+        std::fprintf(stderr, "Failed to write %s\n", file_path);
+        std::exit(1);
+    }
+    std::fclose(output);
+    return file.size();
+}
+
+// Requests every mesh, pumps uploads like the render loop until all of them are ready and releases them.
+template <typename F>
+static double time_uploads(const qz::gfx::Context& context, const std::uint32_t count, F&& request) noexcept {
+    using namespace qz;
+
+    std::vector<meta::Handle<gfx::StaticMesh>> handles;
+    const auto begin = std::chrono::steady_clock::now();
+    for (std::uint32_t i = 0; i < count; ++i) {
+        handles.emplace_back(request());
+    }
+    while (!std::all_of(handles.begin(), handles.end(), [](const auto handle) { return assets::is_ready(handle); })) {
+        gfx::poll_uploads(context);
+        task::poll_timelines(context);
+        (void)gfx::flush_uploads(context);
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    for (const auto handle : handles) {
+        assets::release(context, handle);
+    }
+    return std::chrono::duration<double>(end - begin).count();
+}
+
+int main(int argc, char** argv) {
+    using namespace qz;
+
+    const auto count = argc > 1 ? static_cast<std::uint32_t>(std::atoi(argv[1])) : 16u;
+    const auto size = argc > 2 ? static_cast<std::uint32_t>(std::atoi(argv[2])) : 512u;
+
+    gfx::initialize_window_system();
+    auto context = gfx::Context::create();
+    gfx::initialize_bindless(context);
+    task::initialize_scheduler(context);
+    gfx::initialize_uploads(context);
+
+    const auto grid = make_grid(size);
+    const auto file_size = write_mesh_file(grid);
+    const auto mebibytes = static_cast<double>(file_size) * count / (1024 * 1024);
+    std::printf("%u meshes of %zu vertices and %zu indices, %.1f MiB\n",
+        count, grid.vertices.size() / gfx::vertex_components(grid.attributes), grid.indices.size(), mebibytes);
+
+    // Warms up the staging ring and the geometry blocks so neither run pays for their creation.
+    (void)time_uploads(context, 1, [&]() noexcept {
+        return gfx::request_static_mesh(context, file_path);
+    });
+
+    const auto file_time = time_uploads(context, count, [&]() noexcept {
+        return gfx::request_static_mesh(context, file_path);
+    });
+    std::printf("Mapped file:   %8.2f ms, %8.1f MiB/s\n", file_time * 1000, mebibytes / file_time);
+
+    // The in-memory path gets copies of the float vertices, like a mesh parsed from a text format would.
+    const auto memory_time = time_uploads(context, count, [&]() noexcept {
+        return gfx::request_static_mesh(context, {
+            .geometry = grid.vertices,
+            .indices = grid.indices,
+            .attributes = grid.attributes
+        });
+    });
+    std::printf("In-memory:     %8.2f ms, %8.1f MiB/s\n", memory_time * 1000, mebibytes / memory_time);
+
+    std::remove(file_path);
+    // A mesh can be ready before the task that loaded it has returned.
+    gfx::drain_loader_tasks(context);
+    gfx::wait_queue(context.graphics);
+    gfx::destroy_uploads(context);
+    assets::free_all_resources(context);
+    task::destroy_scheduler(context);
+    gfx::destroy_bindless(context);
+    gfx::Context::destroy(context);
+    gfx::terminate_window_system();
+    return 0;
+}
\ No newline at end of file
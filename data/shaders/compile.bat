@@ -1,7 +1,7 @@
 echo @off
 
-for %%i in (*.vert, *.frag) do (
-    glslc "%%~i" -o "%%~i.spv"
+for %%i in (*.vert, *.frag, *.comp) do (
+    glslc --target-env=vulkan1.2 "%%~i" -o "%%~i.spv"
 )
 
 pause
\ No newline at end of file
@@ -1,4 +1,4 @@
 #!/bin/sh
-for i in *.vert *.frag; do
-  glslc --target-env=vulkan1.1 "$i" -o "$i.spv"
+for i in *.vert *.frag *.comp; do
+  glslc --target-env=vulkan1.2 "$i" -o "$i.spv"
 done
@@ -1,9 +1,22 @@
 #version 460
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec3 color;
+layout (location = 1) in vec2 uv;
 
 layout (location = 0) out vec4 fragment;
 
+layout (set = 0, binding = 1) uniform texture2D textures[];
+layout (set = 0, binding = 2) uniform sampler samplers[2];
+
+// Bindless slot of the texture modulating the vertex color, ~0 until it is ready.
+layout (push_constant) uniform Constants {
+    uint texture_index;
+} constants;
+
 void main() {
     fragment = vec4(color, 1.0);
+    if (constants.texture_index != ~0u) {
+        fragment.rgb *= texture(sampler2D(textures[constants.texture_index], samplers[0]), uv).rgb;
+    }
 }
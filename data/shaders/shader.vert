@@ -2,10 +2,15 @@
 
 layout (location = 0) in vec3 ivertex;
 layout (location = 1) in vec3 icolor;
+// Translation in xyz and uniform scale in w.
+layout (location = 2) in vec4 itransform;
 
 layout (location = 0) out vec3 color;
+layout (location = 1) out vec2 uv;
 
 void main() {
-    gl_Position = vec4(ivertex, 1.0);
+    gl_Position = vec4(ivertex * itransform.w + itransform.xyz, 1.0);
     color = icolor;
+    // Meshes have no texture coordinates yet, the texture is mapped over xy so the quad covers it once.
+    uv = vec2(ivertex.x, 0.5 - ivertex.y);
 }
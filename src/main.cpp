@@ -1,16 +1,33 @@
-#include <qz/gfx/render_pass.hpp>
+#include <qz/gfx/texture_streaming.hpp>
+#include <qz/gfx/render_graph.hpp>
+#include <qz/gfx/shader_store.hpp>
 #include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/draw_queue.hpp>
+#include <qz/gfx/gpu_scene.hpp>
+#include <qz/gfx/instance_ring.hpp>
 #include <qz/gfx/pipeline.hpp>
 #include <qz/gfx/renderer.hpp>
+#include <qz/gfx/bindless.hpp>
 #include <qz/gfx/context.hpp>
+#include <qz/gfx/culling.hpp>
 #include <qz/gfx/window.hpp>
 #include <qz/gfx/assets.hpp>
+#include <qz/gfx/upload.hpp>
 
-#include <qz/meta/constants.hpp>
+#include <qz/task/completion.hpp>
+#include <qz/task/recording.hpp>
 #include <qz/task/scheduler.hpp>
+#include <qz/meta/constants.hpp>
 
+#include <cstdio>
+#include <vector>
+#include <array>
 #include <cmath>
 
+// Culls instances and batches them into one draw per mesh and level of detail in a compute pass,
+// set to false to cull on the CPU and record draws in parallel.
+constexpr auto gpu_driven = true;
+
 int main() {
     using namespace qz;
 
@@ -18,162 +35,304 @@ int main() {
     auto window = gfx::Window::create(1280, 720, "QuartzVk");
     auto context = gfx::Context::create();
     auto renderer = gfx::Renderer::create(context, window);
+    gfx::initialize_bindless(context);
+    gfx::initialize_texture_streaming(context);
     task::initialize_scheduler(context);
+    gfx::initialize_uploads(context);
+
+    // A mesh placed in the scene, translated by xyz and uniformly scaled by w.
+    struct Object {
+        std::uint32_t mesh;
+        std::array<float, 4> transform;
+    };
 
-    auto render_pass = gfx::RenderPass::create(context, {
-        .attachments = { {
-            .image = gfx::Image::create(context, {
-                .width = 1280,
-                .height = 720,
-                .mips = 1,
-                .format = renderer.swapchain.format,
-                .usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT
-            }),
+    std::vector<meta::Handle<gfx::StaticMesh>> meshes;
+    std::vector<Object> objects;
+    // Indices into objects of the ones whose mesh is uploaded, and indices into those of the ones passing culling.
+    std::vector<std::uint32_t> ready;
+    std::vector<std::uint32_t> visible;
+    gfx::InstanceBounds bounds;
+    // Visible objects sorted by pipeline, mesh and depth, the payload indexes into objects.
+    gfx::DrawQueue queue;
+    // Runs of objects sharing a mesh and level of detail, and their transforms and levels in queue order.
+    std::vector<gfx::DrawBatch> batches;
+    std::vector<gfx::DrawBatch> split;
+    std::vector<std::array<float, 4>> transforms;
+    std::vector<std::uint32_t> lods;
+    std::uint32_t first_instance = 0;
+    auto instances = gfx::InstanceRing::create(context, {
+        .capacity = 1024 * 1024
+    });
+    // Meshes not yet added to the GPU scene because their upload didn't finish.
+    std::vector<std::uint32_t> pending;
+    auto scene = gfx::GpuScene::create(context, {
+        .cull_shader = "../data/shaders/cull.comp.spv",
+        .max_meshes = 2048,
+        .max_instances = 2048
+    });
+    meta::Handle<gfx::Pipeline> pipeline{};
+    meta::Handle<gfx::Image> texture{};
+    auto graph = gfx::RenderGraph::create(context, {
+        .images = { {
             .name = "color",
-            .framebuffer = 0,
-            .owning = true,
-            .discard = false,
-            .layout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            .width = 1280,
+            .height = 720,
+            .format = renderer.swapchain.format,
             .clear = gfx::ClearColor{}
         } },
-        .subpasses = { {
-            .attachments = {
+        .passes = { {
+            .name = "main",
+            .writes = {
                 "color"
+            },
+            .contents = VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS,
+            .record = [&](gfx::CommandBuffer& command_buffer, const gfx::RenderPass& render_pass, std::uint32_t, const gfx::FrameInfo& frame) {
+                if (!assets::is_ready(pipeline)) {
+                    return;
+                }
+                // Bindless slot of the texture, the shader skips sampling until it is ready.
+                const auto index = assets::is_ready(texture) ? texture.index : ~0u;
+                if constexpr (gpu_driven) {
+                    task::record_parallel(context, command_buffer, render_pass, 0, frame.index, 1, 1,
+                        [&](gfx::CommandBuffer& secondary, std::size_t, std::size_t) {
+                            secondary
+                                .set_viewport(meta::full_viewport)
+                                .set_scissor(meta::full_scissor)
+                                .bind_pipeline(assets::from_handle(pipeline))
+                                .bind_bindless_table(assets::from_handle(pipeline), frame.index)
+                                .push_constants(assets::from_handle(pipeline), &index, sizeof index);
+                            scene.draw(secondary, frame.index);
+                        });
+                    return;
+                }
+                task::record_parallel(context, command_buffer, render_pass, 0, frame.index, batches.size(), 128,
+                    [&](gfx::CommandBuffer& secondary, const std::size_t begin, const std::size_t end) {
+                        secondary
+                            .set_viewport(meta::full_viewport)
+                            .set_scissor(meta::full_scissor)
+                            .bind_pipeline(assets::from_handle(pipeline))
+                            .bind_bindless_table(assets::from_handle(pipeline), frame.index)
+                            .push_constants(assets::from_handle(pipeline), &index, sizeof index);
+                        instances.bind(secondary);
+                        for (auto i = begin; i < end; ++i) {
+                            const auto& batch = batches[i];
+                            const auto& mesh = assets::from_handle(meshes[objects[queue[batch.first].payload].mesh]);
+                            secondary.draw_static_mesh(mesh, batch.count, first_instance + batch.first, lods[batch.first]);
+                        }
+                    });
             }
         } },
-        .dependencies = { {
-            .source_subpass = meta::external_subpass,
-            .dest_subpass = 0,
-            .source_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .dest_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-            .source_access = {},
-            .dest_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
-        } }
+        .output = "color"
     });
 
-    auto pipeline = gfx::Pipeline::create(context, {
+    pipeline = gfx::request_pipeline(context, {
         .vertex = "../data/shaders/shader.vert.spv",
         .fragment = "../data/shaders/shader.frag.spv",
         .attributes = {
             gfx::VertexAttribute::vec3,
-            gfx::VertexAttribute::vec3,
+            gfx::VertexAttribute::unorm8x4,
+        },
+        .instance_attributes = {
+            gfx::VertexAttribute::vec4
         },
         .states = {
             VK_DYNAMIC_STATE_VIEWPORT,
             VK_DYNAMIC_STATE_SCISSOR
         },
-        .render_pass = render_pass.handle(),
-        .subpass = 0
+        .render_pass = graph.render_pass("main").handle(),
+        .subpass = graph.subpass("main")
     });
+    texture = gfx::request_streamed_texture(context, "../data/textures/checker.dds");
 
-    const auto triangle = gfx::request_static_mesh(context, {
+    meshes.emplace_back(gfx::request_static_mesh(context, {
         .geometry = {
-            -1.0f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f,
-             0.0f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f,
-            -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f
+            -1.0f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+             0.0f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+            -0.5f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f
         },
         .indices = {
             0, 1, 2
+        },
+        .attributes = {
+            gfx::VertexAttribute::vec3,
+            gfx::VertexAttribute::unorm8x4
         }
-    });
+    }));
 
-    const auto quad = gfx::request_static_mesh(context, {
+    meshes.emplace_back(gfx::request_static_mesh(context, {
         .geometry = {
-            0.0f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f,
-            0.0f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f,
-            1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f
+            0.0f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f,
+            0.0f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f, 1.0f,
+            1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f
         },
         .indices = {
             0, 1, 2,
             1, 2, 3
+        },
+        .attributes = {
+            gfx::VertexAttribute::vec3,
+            gfx::VertexAttribute::unorm8x4
         }
-    });
+    }));
 
-    for (int i = 0; i < 1024; ++i) {
-        (void)gfx::request_static_mesh(context, {
-            .geometry = {
-                0.0f,  0.5f, 0.0f, 1.0f, 0.0f, 0.0f,
-                0.0f, -0.5f, 0.0f, 0.0f, 1.0f, 0.0f,
-                1.0f,  0.5f, 0.0f, 0.0f, 1.0f, 0.0f,
-                1.0f, -0.5f, 0.0f, 0.0f, 0.0f, 1.0f
-            },
-            .indices = {
-                0, 1, 2,
-                1, 2, 3
-            }
-        });
+    // Every quad shares one mesh, both paths draw the 1025 of them as one instanced call per level of detail.
+    objects.push_back({ 0, { 0.0f, 0.0f, 0.0f, 1.0f } });
+    for (int i = 0; i < 1025; ++i) {
+        objects.push_back({ 1, { 0.0f, 0.0f, 0.0f, 1.0f } });
+    }
+
+    // Meshes are drawn in clip space for now, so the frustum is the identity's.
+    constexpr float identity[] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    const auto frustum = gfx::Frustum::from_matrix(identity);
+    // Without a camera, a clip space unit spans half the viewport's height seen from about a unit away.
+    const gfx::LodSettings lod_settings{
+        .camera = { 0.0f, 0.0f, -1.0f },
+        .projection_scale = 360.0f
+    };
+    for (std::uint32_t i = 0; i < meshes.size(); ++i) {
+        pending.emplace_back(i);
     }
 
     double delta_time = 0;
     double last_frame = 0;
+#if defined(QUARTZ_DEBUG)
+    double last_report = 0;
+    std::uint64_t elided = 0;
+    std::uint64_t frames = 0;
+#endif
     while (!window.should_close()) {
+        gfx::poll_uploads(context);
+        task::poll_timelines(context);
+        (void)gfx::flush_uploads(context);
         auto [command_buffer, frame] = gfx::acquire_next_frame(renderer, context);
+        gfx::update_bindless(context, frame.index);
+        // The quad spans about 640 pixels across, which wants the texture's most detailed level.
+        gfx::report_texture_usage(texture, 640.0f);
+        gfx::update_texture_streaming(context);
 
         const auto current_frame = gfx::get_time();
         delta_time = current_frame - last_frame;
         last_frame = current_frame;
 
-        gfx::ImageMemoryBarrier transfer_transition{};
-        transfer_transition.image = frame.image;
-        transfer_transition.source_family = meta::family_ignored;
-        transfer_transition.dest_family = meta::family_ignored;
-        transfer_transition.source_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-        transfer_transition.dest_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        transfer_transition.source_access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-        transfer_transition.dest_access = VK_ACCESS_TRANSFER_WRITE_BIT;
-        transfer_transition.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
-        transfer_transition.new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-
-        gfx::ImageMemoryBarrier present_transition{};
-        present_transition.image = frame.image;
-        present_transition.source_family = meta::family_ignored;
-        present_transition.dest_family = meta::family_ignored;
-        present_transition.source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        present_transition.dest_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-        present_transition.source_access = VK_ACCESS_TRANSFER_WRITE_BIT;
-        present_transition.dest_access = {};
-        present_transition.old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        present_transition.new_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        command_buffer
-            .begin()
-            .begin_render_pass(render_pass, 0)
-            .set_viewport(meta::full_viewport)
-            .set_scissor(meta::full_scissor)
-            .bind_pipeline(pipeline);
-
-        if (assets::is_ready(triangle)) {
-            command_buffer
-                .bind_static_mesh(assets::from_handle(triangle))
-                .draw_indexed(3, 1, 0, 0);
+        if constexpr (gpu_driven) {
+            std::erase_if(pending, [&](const std::uint32_t index) {
+                if (!assets::is_ready(meshes[index])) {
+                    return false;
+                }
+                const auto mesh = scene.add_mesh(context, assets::from_handle(meshes[index]));
+                for (const auto& object : objects) {
+                    if (object.mesh == index) {
+                        const auto& transform = object.transform;
+                        (void)scene.add_instance(context, mesh, { transform[0], transform[1], transform[2] }, transform[3]);
+                    }
+                }
+                return true;
+            });
+        } else {
+            ready.clear();
+            bounds.clear();
+            for (std::uint32_t i = 0; i < objects.size(); ++i) {
+                const auto& object = objects[i];
+                if (assets::is_ready(meshes[object.mesh])) {
+                    ready.emplace_back(i);
+                    bounds.push_back(assets::from_handle(meshes[object.mesh]).bounds, object.transform);
+                }
+            }
+            gfx::cull_instances(frustum, bounds, visible);
+
+            queue.clear();
+            for (const auto index : visible) {
+                const auto object = ready[index];
+                const auto key = gfx::make_draw_key(0, queue.pipelines(pipeline.index), 0, queue.meshes(meshes[objects[object].mesh].index), bounds.center_z[index]);
+                queue.push(key, object);
+            }
+            queue.sort();
+            queue.batch(batches);
+
+            transforms.clear();
+            lods.clear();
+            for (std::size_t i = 0; i < queue.size(); ++i) {
+                const auto& object = objects[queue[i].payload];
+                const auto& mesh = assets::from_handle(meshes[object.mesh]);
+                const auto& transform = object.transform;
+                float distance = 0;
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    const auto delta = mesh.bounds.center[axis] * transform[3] + transform[axis] - lod_settings.camera[axis];
+                    distance += delta * delta;
+                }
+                transforms.emplace_back(transform);
+                lods.emplace_back(gfx::select_lod(mesh, std::sqrt(distance) / transform[3], lod_settings.projection_scale, lod_settings.pixels));
+            }
+
+            // Instances of a batch are sorted by depth, so those selecting the same level are mostly adjacent.
+            split.clear();
+            for (const auto& batch : batches) {
+                for (auto i = batch.first; i < batch.first + batch.count; ++i) {
+                    if (i == batch.first || lods[i] != lods[i - 1]) {
+                        split.push_back({ i, 0 });
+                    }
+                    split.back().count++;
+                }
+            }
+            batches.swap(split);
+            instances.begin_frame(frame.index);
+            first_instance = instances.write(transforms.data(), transforms.size(), sizeof(std::array<float, 4>));
+            instances.flush(context);
         }
 
-        if (assets::is_ready(quad)) {
-            command_buffer
-                .bind_static_mesh(assets::from_handle(quad))
-                .draw_indexed(6, 1, 0, 0);
+        // Culling runs on the async compute queue, the frame's graphics work waits for it before reading draws.
+        std::uint64_t culled = 0;
+        if constexpr (gpu_driven) {
+            auto compute_buffer = gfx::acquire_compute_command_buffer(renderer, context, frame);
+            compute_buffer.begin();
+            scene.cull(compute_buffer, frustum, lod_settings, frame.index);
+            compute_buffer.end();
+            culled = gfx::submit_compute(renderer, context, compute_buffer, frame);
         }
 
-        command_buffer
-            .end_render_pass()
-            .insert_layout_transition(transfer_transition)
-            .copy_image(render_pass.attachment("color").image, *frame.image)
-            .insert_layout_transition(present_transition)
-            .end();
+        command_buffer.begin();
+        graph.execute(command_buffer, frame);
+        command_buffer.end();
 
-        gfx::present_frame(renderer, context, command_buffer, frame);
+        gfx::present_frame(renderer, context, command_buffer, frame, culled);
+#if defined(QUARTZ_DEBUG)
+        elided += gfx::take_elided_state_changes();
+        frames++;
+        if (current_frame - last_report >= 1.0) {
+            const auto streaming = gfx::texture_streaming_statistics();
+            std::printf("Elided state changes: %.1f per frame\n", static_cast<double>(elided) / frames);
+            std::printf("Streamed textures: %zu of %zu KiB resident, %zu KiB retiring, %u pending\n",
+                streaming.resident / 1024, streaming.budget / 1024, streaming.retiring / 1024, streaming.pending);
+            last_report = current_frame;
+            elided = 0;
+            frames = 0;
+        }
+#endif
         gfx::poll_events();
     }
+    // Loader and stream tasks may still be staging uploads, parked on a timeline or reading mapped files.
+    gfx::drain_loader_tasks(context);
     gfx::wait_queue(context.graphics);
+    gfx::wait_queue(context.compute);
+    gfx::destroy_uploads(context);
+    gfx::destroy_texture_streaming(context);
     assets::free_all_resources(context);
     task::destroy_scheduler(context);
+    gfx::destroy_bindless(context);
 
-    gfx::Pipeline::destroy(context, pipeline);
-    gfx::RenderPass::destroy(context, render_pass);
+    gfx::InstanceRing::destroy(context, instances);
+    gfx::GpuScene::destroy(context, scene);
+    gfx::RenderGraph::destroy(context, graph);
 
     gfx::Renderer::destroy(context, renderer);
     gfx::Context::destroy(context);
+    gfx::destroy_shaders();
     gfx::Window::destroy(window);
 
     gfx::terminate_window_system();
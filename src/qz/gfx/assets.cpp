@@ -1,54 +1,191 @@
 #include <qz/gfx/static_mesh.hpp>
-#include <qz/gfx/buffer.hpp>
+#include <qz/gfx/geometry.hpp>
+#include <qz/gfx/pipeline.hpp>
+#include <qz/gfx/image.hpp>
 #include <qz/gfx/assets.hpp>
 
+#include <atomic>
+#include <vector>
+#include <array>
 #include <mutex>
 
 namespace qz::assets {
+    // Assets live in fixed size chunks that are never moved, references stay valid while the table grows.
+    constexpr auto chunk_size = 256u;
+    constexpr auto max_chunks = 4096u;
+
     template <typename T>
     struct InternalStorage {
         T object;
-        bool done;
+        std::atomic<std::uint32_t> generation;
+        std::atomic<bool> done;
     };
 
     template <typename T>
-    static std::vector<InternalStorage<T>> assets;
+    static std::array<std::atomic<InternalStorage<T>*>, max_chunks> chunks;
 
     template <typename T>
-    static std::mutex done_mutex;
+    static std::atomic<std::uint32_t> slot_count;
 
-    template <>
-    qz_nodiscard meta::Handle<gfx::StaticMesh> emplace_empty() noexcept {
-        std::lock_guard<std::mutex> lock(done_mutex<gfx::StaticMesh>);
-        assets<gfx::StaticMesh>.emplace_back();
-        return { assets<gfx::StaticMesh>.size() - 1 };
+    // Only emplace and release touch the recycled slots, lookups never lock.
+    template <typename T>
+    static std::mutex free_mutex;
+
+    template <typename T>
+    static std::vector<std::uint32_t> free_slots;
+
+    template <typename T>
+    qz_nodiscard static InternalStorage<T>& storage(const std::uint32_t index) noexcept {
+        const auto chunk = chunks<T>[index / chunk_size].load(std::memory_order_acquire);
+        qz_assert(chunk != nullptr, "Invalid asset handle");
+        return chunk[index % chunk_size];
+    }
+
+    template <typename T>
+    qz_nodiscard static InternalStorage<T>& storage(const meta::Handle<T> handle) noexcept {
+        qz_assert(handle.index < slot_count<T>.load(std::memory_order_relaxed), "Invalid asset handle");
+        auto& slot = storage<T>(handle.index);
+        qz_assert(slot.generation.load(std::memory_order_relaxed) == handle.generation, "Stale asset handle");
+        return slot;
+    }
+
+    template <typename T>
+    qz_nodiscard meta::Handle<T> emplace_empty() noexcept {
+        {
+            std::lock_guard<std::mutex> lock(free_mutex<T>);
+            if (!free_slots<T>.empty()) {
+                const auto index = free_slots<T>.back();
+                free_slots<T>.pop_back();
+                return { index, storage<T>(index).generation.load(std::memory_order_relaxed) };
+            }
+        }
+
+        const auto index = slot_count<T>.fetch_add(1, std::memory_order_relaxed);
+        if (index >= chunk_size * max_chunks) {
+            qz_force_assert("Asset table is full");
+        }
+        auto& chunk = chunks<T>[index / chunk_size];
+        if (!chunk.load(std::memory_order_acquire)) {
+            // Whoever loses the race to publish the chunk throws its own away.
+            auto* expected = static_cast<InternalStorage<T>*>(nullptr);
+            auto* created = new InternalStorage<T>[chunk_size]();
+            if (!chunk.compare_exchange_strong(expected, created, std::memory_order_acq_rel)) {
+                delete[] created;
+            }
+        }
+        return { index, 0 };
+    }
+
+    template <typename T>
+    qz_nodiscard T& from_handle(const meta::Handle<T> handle) noexcept {
+        return storage(handle).object;
+    }
+
+    template <typename T>
+    void finalize(const meta::Handle<T> handle) noexcept {
+        // Publishes every write to the object made before the asset was finalized.
+        storage(handle).done.store(true, std::memory_order_release);
+    }
+
+    template <typename T>
+    bool is_ready(const meta::Handle<T> handle) noexcept {
+        // Probed with any handle, stale or default ones may point past the table or at a chunk never allocated.
+        if (handle.index / chunk_size >= max_chunks) {
+            return false;
+        }
+        const auto chunk = chunks<T>[handle.index / chunk_size].load(std::memory_order_acquire);
+        if (!chunk) {
+            return false;
+        }
+        const auto& slot = chunk[handle.index % chunk_size];
+        // Generation is checked after the flag, a slot recycled in between is never reported ready.
+        return slot.done.load(std::memory_order_acquire) &&
+               slot.generation.load(std::memory_order_acquire) == handle.generation;
+    }
+
+    template <typename T>
+    static void recycle(const meta::Handle<T> handle) noexcept {
+        auto& slot = storage(handle);
+        slot.done.store(false, std::memory_order_relaxed);
+        slot.object = {};
+        slot.generation.fetch_add(1, std::memory_order_release);
+
+        std::lock_guard<std::mutex> lock(free_mutex<T>);
+        free_slots<T>.emplace_back(handle.index);
     }
 
     template <>
-    qz_nodiscard gfx::StaticMesh& from_handle(const meta::Handle<gfx::StaticMesh> handle) noexcept {
-        std::lock_guard<std::mutex> lock(done_mutex<gfx::StaticMesh>);
-        qz_assert(0 <= handle.index && handle.index < assets<gfx::StaticMesh>.size(), "Invalid mesh handle");
-        return assets<gfx::StaticMesh>[handle.index].object;
+    void release(const gfx::Context&, const meta::Handle<gfx::StaticMesh> handle) noexcept {
+        qz_assert(is_ready(handle), "Released a mesh that is still uploading");
+        gfx::free_geometry(from_handle(handle).geometry);
+        recycle(handle);
     }
 
     template <>
-    void finalize(const meta::Handle<gfx::StaticMesh> handle) noexcept {
-        std::lock_guard<std::mutex> lock(done_mutex<gfx::StaticMesh>);
-        qz_assert(0 <= handle.index && handle.index < assets<gfx::StaticMesh>.size(), "Invalid mesh handle");
-        assets<gfx::StaticMesh>[handle.index].done = true;
+    void release(const gfx::Context& context, const meta::Handle<gfx::Pipeline> handle) noexcept {
+        qz_assert(is_ready(handle), "Released a pipeline that is still compiling");
+        gfx::Pipeline::destroy(context, from_handle(handle));
+        recycle(handle);
     }
 
     template <>
-    bool is_ready(const meta::Handle<gfx::StaticMesh> handle) noexcept {
-        std::lock_guard<std::mutex> lock(done_mutex<gfx::StaticMesh>);
-        qz_assert(0 <= handle.index && handle.index < assets<gfx::StaticMesh>.size(), "Invalid mesh handle");
-        return assets<gfx::StaticMesh>[handle.index].done;
+    void release(const gfx::Context& context, const meta::Handle<gfx::Image> handle) noexcept {
+        qz_assert(is_ready(handle), "Released a texture that is still uploading");
+        gfx::Image::destroy(context, from_handle(handle));
+        recycle(handle);
+    }
+
+    template meta::Handle<gfx::StaticMesh> emplace_empty<gfx::StaticMesh>() noexcept;
+    template gfx::StaticMesh& from_handle<gfx::StaticMesh>(meta::Handle<gfx::StaticMesh>) noexcept;
+    template void finalize<gfx::StaticMesh>(meta::Handle<gfx::StaticMesh>) noexcept;
+    template bool is_ready<gfx::StaticMesh>(meta::Handle<gfx::StaticMesh>) noexcept;
+
+    template meta::Handle<gfx::Pipeline> emplace_empty<gfx::Pipeline>() noexcept;
+    template gfx::Pipeline& from_handle<gfx::Pipeline>(meta::Handle<gfx::Pipeline>) noexcept;
+    template void finalize<gfx::Pipeline>(meta::Handle<gfx::Pipeline>) noexcept;
+    template bool is_ready<gfx::Pipeline>(meta::Handle<gfx::Pipeline>) noexcept;
+
+    template meta::Handle<gfx::Image> emplace_empty<gfx::Image>() noexcept;
+    template gfx::Image& from_handle<gfx::Image>(meta::Handle<gfx::Image>) noexcept;
+    template void finalize<gfx::Image>(meta::Handle<gfx::Image>) noexcept;
+    template bool is_ready<gfx::Image>(meta::Handle<gfx::Image>) noexcept;
+
+    template <typename T>
+    static void free_chunks() noexcept {
+        for (auto& each : chunks<T>) {
+            delete[] each.exchange(nullptr);
+        }
+        slot_count<T> = 0;
+        free_slots<T> = {};
     }
 
     void free_all_resources(const gfx::Context& context) noexcept {
-        for (auto& each : assets<gfx::StaticMesh>) {
-            gfx::Buffer::destroy(context, each.object.geometry);
-            gfx::Buffer::destroy(context, each.object.indices);
+        const auto meshes = slot_count<gfx::StaticMesh>.load();
+        for (std::uint32_t i = 0; i < meshes; ++i) {
+            const auto& each = storage<gfx::StaticMesh>(i);
+            if (each.done.load(std::memory_order_acquire)) {
+                gfx::free_geometry(each.object.geometry);
+            }
+        }
+        free_chunks<gfx::StaticMesh>();
+        gfx::destroy_geometry(context);
+
+        const auto pipelines = slot_count<gfx::Pipeline>.load();
+        for (std::uint32_t i = 0; i < pipelines; ++i) {
+            auto& each = storage<gfx::Pipeline>(i);
+            if (each.done.load(std::memory_order_acquire)) {
+                gfx::Pipeline::destroy(context, each.object);
+            }
+        }
+        free_chunks<gfx::Pipeline>();
+
+        const auto images = slot_count<gfx::Image>.load();
+        for (std::uint32_t i = 0; i < images; ++i) {
+            auto& each = storage<gfx::Image>(i);
+            if (each.done.load(std::memory_order_acquire)) {
+                gfx::Image::destroy(context, each.object);
+            }
         }
+        free_chunks<gfx::Image>();
     }
 } // namespace qz::assets
\ No newline at end of file
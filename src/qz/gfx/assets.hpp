@@ -13,8 +13,13 @@ namespace qz::assets {
     template <typename T>
     void finalize(meta::Handle<T>) noexcept;
 
+    // Wait-free, safe to call from the render thread while other tasks are emplacing.
     template <typename T>
     bool is_ready(meta::Handle<T>) noexcept;
 
+    // Frees the asset's resources and recycles its slot, the GPU must no longer be using it.
+    template <typename T>
+    void release(const gfx::Context&, meta::Handle<T>) noexcept;
+
     void free_all_resources(const gfx::Context&) noexcept;
 } // namespace qz::assets
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/context.hpp>
+#include <qz/gfx/buffer.hpp>
+#include <qz/gfx/image.hpp>
+
+#include <qz/meta/types.hpp>
+
+#include <algorithm>
+#include <vector>
+#include <array>
+#include <mutex>
+
+namespace qz::gfx {
+    // Upper bounds of the table, clamped to what the device allows with update-after-bind.
+    constexpr auto max_bindless_buffers = 65536u;
+    constexpr auto max_bindless_images = 65536u;
+    constexpr auto all_frames = (1u << meta::in_flight) - 1;
+
+    // Image replacement waiting to reach the sets of the frames still marked in the mask.
+    struct PendingReplacement {
+        std::uint32_t index;
+        VkImageView view;
+        std::uint32_t frames;
+    };
+
+    // vkUpdateDescriptorSets must be externally synchronized on the set, writes come from loader tasks.
+    static std::mutex write_mutex;
+    static std::vector<PendingReplacement> replacements;
+    static VkDescriptorSetLayout set_layout;
+    static VkDescriptorPool descriptor_pool;
+    static meta::in_flight_array<VkDescriptorSet> descriptor_sets;
+    static std::array<VkSampler, bindless_sampler_count> samplers;
+    static std::uint32_t buffer_capacity;
+    static std::uint32_t image_capacity;
+
+    qz_nodiscard static VkSampler make_sampler(const Context& context, const VkFilter filter, const VkSamplerMipmapMode mipmap_mode) noexcept {
+        VkSamplerCreateInfo sampler_create_info{};
+        sampler_create_info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        sampler_create_info.magFilter = filter;
+        sampler_create_info.minFilter = filter;
+        sampler_create_info.mipmapMode = mipmap_mode;
+        sampler_create_info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_create_info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_create_info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        sampler_create_info.minLod = 0;
+        sampler_create_info.maxLod = VK_LOD_CLAMP_NONE;
+        sampler_create_info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+
+        VkSampler sampler;
+        qz_vulkan_check(vkCreateSampler(context.device, &sampler_create_info, nullptr, &sampler));
+        return sampler;
+    }
+
+    void initialize_bindless(const Context& context) noexcept {
+        VkPhysicalDeviceVulkan12Properties vulkan12_properties{};
+        vulkan12_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &vulkan12_properties;
+        vkGetPhysicalDeviceProperties2(context.gpu, &properties);
+        buffer_capacity = std::min({
+            max_bindless_buffers,
+            vulkan12_properties.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+            vulkan12_properties.maxDescriptorSetUpdateAfterBindStorageBuffers
+        });
+        image_capacity = std::min({
+            max_bindless_images,
+            vulkan12_properties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            vulkan12_properties.maxDescriptorSetUpdateAfterBindSampledImages
+        });
+        // Every frame in flight has its own copy of the table, all of them come from the same pool.
+        const auto pool_limit = vulkan12_properties.maxUpdateAfterBindDescriptorsInAllPools / (2 * meta::in_flight);
+        buffer_capacity = std::min(buffer_capacity, pool_limit);
+        image_capacity = std::min(image_capacity, pool_limit);
+
+        samplers[bindless_linear_sampler] = make_sampler(context, VK_FILTER_LINEAR, VK_SAMPLER_MIPMAP_MODE_LINEAR);
+        samplers[bindless_nearest_sampler] = make_sampler(context, VK_FILTER_NEAREST, VK_SAMPLER_MIPMAP_MODE_NEAREST);
+
+        const VkDescriptorSetLayoutBinding bindings[] = { {
+            .binding = bindless_buffer_binding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+            .descriptorCount = buffer_capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = nullptr
+        }, {
+            .binding = bindless_image_binding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+            .descriptorCount = image_capacity,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = nullptr
+        }, {
+            .binding = bindless_sampler_binding,
+            .descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER,
+            .descriptorCount = bindless_sampler_count,
+            .stageFlags = VK_SHADER_STAGE_ALL,
+            .pImmutableSamplers = samplers.data()
+        } };
+        // Slots are filled as assets finish loading, nothing guarantees every slot a shader could reach is valid.
+        constexpr VkDescriptorBindingFlags resource_flags =
+            VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+            VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT;
+        const VkDescriptorBindingFlags binding_flags[] = { resource_flags, resource_flags, 0 };
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_create_info{};
+        binding_flags_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_create_info.bindingCount = std::size(binding_flags);
+        binding_flags_create_info.pBindingFlags = binding_flags;
+
+        VkDescriptorSetLayoutCreateInfo set_layout_create_info{};
+        set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_layout_create_info.pNext = &binding_flags_create_info;
+        set_layout_create_info.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        set_layout_create_info.bindingCount = std::size(bindings);
+        set_layout_create_info.pBindings = bindings;
+        qz_vulkan_check(vkCreateDescriptorSetLayout(context.device, &set_layout_create_info, nullptr, &set_layout));
+
+        const VkDescriptorPoolSize pool_sizes[] = {
+            { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, buffer_capacity * meta::in_flight },
+            { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, image_capacity * meta::in_flight },
+            { VK_DESCRIPTOR_TYPE_SAMPLER, bindless_sampler_count * meta::in_flight }
+        };
+        VkDescriptorPoolCreateInfo pool_create_info{};
+        pool_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        pool_create_info.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        pool_create_info.maxSets = meta::in_flight;
+        pool_create_info.poolSizeCount = std::size(pool_sizes);
+        pool_create_info.pPoolSizes = pool_sizes;
+        qz_vulkan_check(vkCreateDescriptorPool(context.device, &pool_create_info, nullptr, &descriptor_pool));
+
+        meta::in_flight_array<VkDescriptorSetLayout> set_layouts;
+        set_layouts.fill(set_layout);
+        VkDescriptorSetAllocateInfo set_allocate_info{};
+        set_allocate_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        set_allocate_info.descriptorPool = descriptor_pool;
+        set_allocate_info.descriptorSetCount = meta::in_flight;
+        set_allocate_info.pSetLayouts = set_layouts.data();
+        qz_vulkan_check(vkAllocateDescriptorSets(context.device, &set_allocate_info, descriptor_sets.data()));
+    }
+
+    // Writes the same descriptor to the sets of every frame whose bit is set in the mask.
+    static void write_sets(const Context& context, VkWriteDescriptorSet write, const std::uint32_t frames) noexcept {
+        std::array<VkWriteDescriptorSet, meta::in_flight> writes;
+        std::uint32_t count = 0;
+        for (std::uint32_t frame = 0; frame < meta::in_flight; ++frame) {
+            if (frames & (1u << frame)) {
+                write.dstSet = descriptor_sets[frame];
+                writes[count++] = write;
+            }
+        }
+        vkUpdateDescriptorSets(context.device, count, writes.data(), 0, nullptr);
+    }
+
+    void write_bindless_buffer(const Context& context, const std::uint32_t index, const Buffer& buffer, const std::size_t offset, const std::size_t size) noexcept {
+        if (index >= buffer_capacity) {
+            qz_force_assert("Bindless buffer table is full");
+        }
+        const VkDescriptorBufferInfo buffer_info{ buffer.handle, offset, size };
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = bindless_buffer_binding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.pBufferInfo = &buffer_info;
+
+        std::lock_guard<std::mutex> lock(write_mutex);
+        write_sets(context, write, all_frames);
+    }
+
+    void write_bindless_image(const Context& context, const std::uint32_t index, const Image& image) noexcept {
+        if (index >= image_capacity) {
+            qz_force_assert("Bindless image table is full");
+        }
+        const VkDescriptorImageInfo image_info{ nullptr, image.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = bindless_image_binding;
+        write.dstArrayElement = index;
+        write.descriptorCount = 1;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+        write.pImageInfo = &image_info;
+
+        std::lock_guard<std::mutex> lock(write_mutex);
+        write_sets(context, write, all_frames);
+    }
+
+    void replace_bindless_image(const std::uint32_t index, const Image& image) noexcept {
+        if (index >= image_capacity) {
+            qz_force_assert("Bindless image table is full");
+        }
+        std::lock_guard<std::mutex> lock(write_mutex);
+        // A newer replacement of the same slot supersedes one that hasn't reached every set yet.
+        const auto it = std::find_if(replacements.begin(), replacements.end(), [index](const auto& each) {
+            return each.index == index;
+        });
+        if (it != replacements.end()) {
+            *it = { index, image.view, all_frames };
+        } else {
+            replacements.push_back({ index, image.view, all_frames });
+        }
+    }
+
+    void update_bindless(const Context& context, const std::uint32_t frame) noexcept {
+        std::lock_guard<std::mutex> lock(write_mutex);
+        for (auto& each : replacements) {
+            const VkDescriptorImageInfo image_info{ nullptr, each.view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+            VkWriteDescriptorSet write{};
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.dstBinding = bindless_image_binding;
+            write.dstArrayElement = each.index;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+            write.pImageInfo = &image_info;
+            write_sets(context, write, each.frames & (1u << frame));
+            each.frames &= ~(1u << frame);
+        }
+        std::erase_if(replacements, [](const auto& each) {
+            return each.frames == 0;
+        });
+    }
+
+    qz_nodiscard VkDescriptorSetLayout bindless_set_layout() noexcept {
+        return set_layout;
+    }
+
+    qz_nodiscard VkDescriptorSet bindless_descriptor_set(const std::uint32_t frame) noexcept {
+        return descriptor_sets[frame];
+    }
+
+    void destroy_bindless(const Context& context) noexcept {
+        vkDestroyDescriptorPool(context.device, descriptor_pool, nullptr);
+        vkDestroyDescriptorSetLayout(context.device, set_layout, nullptr);
+        for (auto& each : samplers) {
+            vkDestroySampler(context.device, each, nullptr);
+            each = nullptr;
+        }
+        descriptor_pool = nullptr;
+        set_layout = nullptr;
+        descriptor_sets = {};
+        replacements = {};
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace qz::gfx {
+    // Descriptor set every pipeline reserves for the bindless table. Shaders declare it as
+    //   layout (set = 0, binding = 0) buffer ... [];     storage buffers, indexed by asset handle
+    //   layout (set = 0, binding = 1) uniform texture2D [];
+    //   layout (set = 0, binding = 2) uniform sampler [bindless_sampler_count];
+    // and receive the indices they need through push constants.
+    constexpr auto bindless_set = 0u;
+    constexpr auto bindless_buffer_binding = 0u;
+    constexpr auto bindless_image_binding = 1u;
+    constexpr auto bindless_sampler_binding = 2u;
+
+    constexpr auto bindless_linear_sampler = 0u;
+    constexpr auto bindless_nearest_sampler = 1u;
+    constexpr auto bindless_sampler_count = 2u;
+
+    // Creates the table, one update-after-bind descriptor set per frame in flight and the immutable samplers.
+    void initialize_bindless(const Context&) noexcept;
+
+    // Points the given slot at the buffer range in every frame's set. Safe to call from any task, but only for
+    // slots no pending command buffer uses, which holds for assets that just finished loading.
+    void write_bindless_buffer(const Context&, std::uint32_t, const Buffer&, std::size_t = 0, std::size_t = VK_WHOLE_SIZE) noexcept;
+    // Points the given slot at the image's view, which must be in SHADER_READ_ONLY_OPTIMAL layout when sampled.
+    void write_bindless_image(const Context&, std::uint32_t, const Image&) noexcept;
+    // Points a slot frames in flight may be sampling at a new image. Each frame's set is only updated by
+    // update_bindless() once that frame has finished, so the old view must outlive every frame in flight after that.
+    void replace_bindless_image(std::uint32_t, const Image&) noexcept;
+    // Applies replacements queued for the given frame's set, its previous submission must have completed.
+    void update_bindless(const Context&, std::uint32_t) noexcept;
+
+    qz_nodiscard VkDescriptorSetLayout bindless_set_layout() noexcept;
+    qz_nodiscard VkDescriptorSet bindless_descriptor_set(std::uint32_t) noexcept;
+    void destroy_bindless(const Context&) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
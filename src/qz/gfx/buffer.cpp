@@ -1,6 +1,9 @@
 #include <qz/gfx/context.hpp>
 #include <qz/gfx/buffer.hpp>
 
+#include <algorithm>
+#include <atomic>
+
 namespace qz::gfx {
     qz_nodiscard Buffer Buffer::create(const Context& context, CreateInfo&& info) noexcept {
         VkBufferCreateInfo buffer_create_info{};
@@ -8,9 +11,15 @@ namespace qz::gfx {
         buffer_create_info.flags = {};
         buffer_create_info.size = info.capacity;
         buffer_create_info.usage = info.flags;
-        buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        buffer_create_info.queueFamilyIndexCount = 1;
-        buffer_create_info.pQueueFamilyIndices = &context.family;
+        const std::uint32_t families[] = { context.family, context.compute_family };
+        if (info.concurrent && context.family != context.compute_family) {
+            buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            buffer_create_info.queueFamilyIndexCount = 2;
+        } else {
+            buffer_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            buffer_create_info.queueFamilyIndexCount = 1;
+        }
+        buffer_create_info.pQueueFamilyIndices = families;
 
         VmaAllocationCreateInfo allocation_create_info{};
         allocation_create_info.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
@@ -32,6 +41,12 @@ namespace qz::gfx {
             &allocation_info));
         buffer.capacity = info.capacity;
         buffer.mapped = allocation_info.pMappedData;
+        if (info.flags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+            VkBufferDeviceAddressInfo address_info{};
+            address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+            address_info.buffer = buffer.handle;
+            buffer.address = vkGetBufferDeviceAddress(context.device, &address_info);
+        }
 
         return buffer;
     }
@@ -40,4 +55,87 @@ namespace qz::gfx {
         vmaDestroyBuffer(context.allocator, buffer.handle, buffer.allocation);
         buffer = {};
     }
+
+    qz_nodiscard StagingRing StagingRing::create(const Context& context, CreateInfo&& info) noexcept {
+        qz_assert((info.alignment & (info.alignment - 1)) == 0, "Staging alignment must be a power of two");
+        StagingRing ring{};
+        ring.buffer = Buffer::create(context, {
+            .flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+            .capacity = info.capacity
+        });
+        ring.alignment = info.alignment;
+
+        return ring;
+    }
+
+    void StagingRing::destroy(const Context& context, StagingRing& ring) noexcept {
+        Buffer::destroy(context, ring.buffer);
+        ring = {};
+    }
+
+    qz_nodiscard std::optional<StagingSlice> StagingRing::allocate(const std::size_t size) noexcept {
+        qz_assert(size <= max_allocation(), "Staging allocation exceeds ring capacity");
+        // Sizes are rounded to the alignment so the head always stays aligned.
+        const auto aligned_size = (size + alignment - 1) & ~(alignment - 1);
+        const auto capacity = buffer.capacity;
+
+        std::atomic_ref<std::size_t> head_ref(head);
+        std::atomic_ref<std::size_t> tail_ref(tail);
+        auto current = head_ref.load(std::memory_order_relaxed);
+        std::size_t begin;
+        do {
+            begin = current;
+            if (begin % capacity + aligned_size > capacity) {
+                // Slice would straddle the end of the ring, skip to the beginning.
+                begin += capacity - begin % capacity;
+            }
+            if (begin + aligned_size - tail_ref.load(std::memory_order_acquire) > capacity) {
+                std::atomic_ref<std::size_t>(stalls).fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+        } while (!head_ref.compare_exchange_weak(current, begin + aligned_size, std::memory_order_acq_rel));
+
+        std::atomic_ref<std::size_t>(allocations).fetch_add(1, std::memory_order_relaxed);
+        std::atomic_ref<std::size_t> peak_ref(peak_occupancy);
+        const auto occupancy = begin + aligned_size - tail_ref.load(std::memory_order_relaxed);
+        auto peak = peak_ref.load(std::memory_order_relaxed);
+        while (peak < occupancy && !peak_ref.compare_exchange_weak(peak, occupancy, std::memory_order_relaxed));
+
+        const auto offset = begin % capacity;
+        return StagingSlice{
+            buffer.handle,
+            offset,
+            begin,
+            size,
+            static_cast<char*>(buffer.mapped) + offset
+        };
+    }
+
+    void StagingRing::release(const std::size_t position) noexcept {
+        std::atomic_ref<std::size_t> tail_ref(tail);
+        auto current = tail_ref.load(std::memory_order_relaxed);
+        while (current < position && !tail_ref.compare_exchange_weak(current, position, std::memory_order_release));
+    }
+
+    qz_nodiscard std::size_t StagingRing::max_allocation() const noexcept {
+        // With the head aligned, skipping to the beginning wastes less than one slice,
+        // so anything up to half the ring fits once it is empty.
+        return buffer.capacity / 2;
+    }
+
+    qz_nodiscard std::size_t StagingRing::current_head() noexcept {
+        return std::atomic_ref<std::size_t>(head).load(std::memory_order_acquire);
+    }
+
+    qz_nodiscard StagingRing::Statistics StagingRing::statistics() noexcept {
+        const auto current_tail = std::atomic_ref<std::size_t>(tail).load(std::memory_order_relaxed);
+        return {
+            buffer.capacity,
+            current_head() - current_tail,
+            std::atomic_ref<std::size_t>(peak_occupancy).load(std::memory_order_relaxed),
+            std::atomic_ref<std::size_t>(allocations).load(std::memory_order_relaxed),
+            std::atomic_ref<std::size_t>(stalls).load(std::memory_order_relaxed)
+        };
+    }
 } // namespace qz::gfx
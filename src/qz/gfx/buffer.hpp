@@ -6,20 +6,74 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 
+#include <optional>
+#include <cstdint>
+
 namespace qz::gfx {
     struct Buffer {
         struct CreateInfo {
             VkBufferUsageFlags flags;
             VmaMemoryUsage usage;
             std::size_t capacity;
+            // Shared by the graphics and async compute families without ownership transfers.
+            bool concurrent;
         };
 
         VmaAllocation allocation;
         std::size_t capacity;
         VkBuffer handle;
         void* mapped;
+        // Only queried for buffers created with VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT.
+        VkDeviceAddress address;
 
         qz_nodiscard static Buffer create(const Context&, CreateInfo&&) noexcept;
         static void destroy(const Context&, Buffer&) noexcept;
     };
+
+    struct StagingSlice {
+        VkBuffer handle;
+        std::size_t offset;
+        std::size_t position;
+        std::size_t size;
+        void* mapped;
+    };
+
+    // Persistently mapped CPU_ONLY buffer handing out slices with a lock-free bump allocator.
+    // Positions grow monotonically and wrap around the buffer, slices are reclaimed in order with release().
+    struct StagingRing {
+        struct CreateInfo {
+            std::size_t capacity;
+            std::size_t alignment;
+        };
+
+        struct Statistics {
+            std::size_t capacity;
+            std::size_t occupancy;
+            std::size_t peak_occupancy;
+            std::size_t allocations;
+            std::size_t stalls;
+        };
+
+        Buffer buffer;
+        std::size_t alignment;
+        // Accessed through std::atomic_ref, keeps the ring a plain aggregate like every other resource.
+        alignas(64) std::size_t head;
+        alignas(64) std::size_t tail;
+        std::size_t peak_occupancy;
+        std::size_t allocations;
+        std::size_t stalls;
+
+        qz_nodiscard static StagingRing create(const Context&, CreateInfo&&) noexcept;
+        static void destroy(const Context&, StagingRing&) noexcept;
+
+        // Returns std::nullopt and counts a stall if the ring has no room left.
+        qz_nodiscard std::optional<StagingSlice> allocate(std::size_t) noexcept;
+        // Reclaims every slice whose position lies before the given one.
+        void release(std::size_t) noexcept;
+
+        // Largest slice that is guaranteed to fit once the ring drains.
+        qz_nodiscard std::size_t max_allocation() const noexcept;
+        qz_nodiscard std::size_t current_head() noexcept;
+        qz_nodiscard Statistics statistics() noexcept;
+    };
 } // namespace qz::gfx
\ No newline at end of file
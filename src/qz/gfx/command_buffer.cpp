@@ -2,16 +2,25 @@
 #include <qz/gfx/static_mesh.hpp>
 #include <qz/gfx/render_pass.hpp>
 #include <qz/gfx/pipeline.hpp>
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/geometry.hpp>
 #include <qz/gfx/context.hpp>
 #include <qz/gfx/buffer.hpp>
 
+#include <cstring>
+#include <atomic>
+#include <vector>
+
 namespace qz::gfx {
-    qz_nodiscard CommandBuffer CommandBuffer::allocate(const Context& context,  VkCommandPool command_pool) noexcept {
+    // Command buffers are recorded on any worker, each one only touches the counter when it ends.
+    static std::atomic<std::uint64_t> elided_state_changes;
+
+    qz_nodiscard CommandBuffer CommandBuffer::allocate(const Context& context, VkCommandPool command_pool, const VkCommandBufferLevel level) noexcept {
         VkCommandBuffer command_buffer{};
         VkCommandBufferAllocateInfo allocate_info{};
         allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocate_info.commandPool = command_pool;
-        allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocate_info.level = level;
         allocate_info.commandBufferCount = 1;
         qz_vulkan_check(vkAllocateCommandBuffers(context.device, &allocate_info, &command_buffer));
 
@@ -22,10 +31,23 @@ namespace qz::gfx {
         CommandBuffer command_buffer{};
         command_buffer._handle = handle;
         command_buffer._pool = command_pool;
+        command_buffer._elided_state_changes = 0;
+        command_buffer.forget_state();
 
         return command_buffer;
     }
 
+    void CommandBuffer::forget_state() noexcept {
+        _geometry_block = -1;
+        _vertex_buffers = {};
+        _index_buffer = nullptr;
+        _pipelines = {};
+        _layouts = {};
+        _has_viewport = false;
+        _has_scissor = false;
+        _push_constant_layout = nullptr;
+    }
+
     void CommandBuffer::destroy(const Context& context, CommandBuffer& command_buffer) noexcept {
         vkFreeCommandBuffers(context.device, command_buffer._pool, 1, &command_buffer._handle);
         command_buffer = {};
@@ -48,11 +70,31 @@ namespace qz::gfx {
         begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
         begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
+        forget_state();
         qz_vulkan_check(vkBeginCommandBuffer(_handle, &begin_info));
         return *this;
     }
 
-    CommandBuffer& CommandBuffer::begin_render_pass(const RenderPass& render_pass, const std::size_t framebuffer) noexcept {
+    CommandBuffer& CommandBuffer::begin_secondary(const RenderPass& render_pass, const std::size_t framebuffer, const std::uint32_t subpass) noexcept {
+        _active_pass = &render_pass;
+
+        VkCommandBufferInheritanceInfo inheritance_info{};
+        inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance_info.renderPass = render_pass.handle();
+        inheritance_info.subpass = subpass;
+        inheritance_info.framebuffer = render_pass.framebuffer(framebuffer);
+
+        VkCommandBufferBeginInfo begin_info{};
+        begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        begin_info.pInheritanceInfo = &inheritance_info;
+
+        forget_state();
+        qz_vulkan_check(vkBeginCommandBuffer(_handle, &begin_info));
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::begin_render_pass(const RenderPass& render_pass, const std::size_t framebuffer, const VkSubpassContents contents) noexcept {
         _active_pass = &render_pass;
         const auto clear_values = render_pass.clears();
 
@@ -63,7 +105,7 @@ namespace qz::gfx {
         begin_info.renderArea.extent = render_pass.extent();
         begin_info.clearValueCount = clear_values.size();
         begin_info.pClearValues = clear_values.data();
-        vkCmdBeginRenderPass(_handle, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(_handle, &begin_info, contents);
         return *this;
     }
 
@@ -76,49 +118,151 @@ namespace qz::gfx {
         viewport.height = extent.height;
         viewport.minDepth = 0.0f;
         viewport.maxDepth = 1.0f;
-        vkCmdSetViewport(_handle, 0, 1, &viewport);
-        return *this;
+        return set_viewport(viewport);
     }
 
     CommandBuffer& CommandBuffer::set_viewport(VkViewport viewport) noexcept {
+        if (_has_viewport && std::memcmp(&_viewport, &viewport, sizeof(VkViewport)) == 0) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _viewport = viewport;
+        _has_viewport = true;
         vkCmdSetViewport(_handle, 0, 1, &viewport);
         return *this;
     }
 
     CommandBuffer& CommandBuffer::set_scissor(meta::scissor_tag_t) noexcept {
         const auto extent = _active_pass->extent();
-        VkRect2D scissor{ {}, extent };
-        vkCmdSetScissor(_handle, 0, 1, &scissor);
-        return *this;
+        return set_scissor(VkRect2D{ {}, extent });
     }
 
     CommandBuffer& CommandBuffer::set_scissor(VkRect2D scissor) noexcept {
+        if (_has_scissor && std::memcmp(&_scissor, &scissor, sizeof(VkRect2D)) == 0) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _scissor = scissor;
+        _has_scissor = true;
         vkCmdSetScissor(_handle, 0, 1, &scissor);
         return *this;
     }
 
     CommandBuffer& CommandBuffer::bind_pipeline(const Pipeline& pipeline) noexcept {
+        qz_assert(pipeline.bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS, "Compute pipelines are bound with bind_compute_pipeline()");
+        if (_pipelines[0] == pipeline.handle) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _pipelines[0] = pipeline.handle;
+        // Dynamic state survives a bind only if the new pipeline leaves it dynamic too.
+        _has_viewport &= (pipeline.dynamic_states >> VK_DYNAMIC_STATE_VIEWPORT) & 1;
+        _has_scissor &= (pipeline.dynamic_states >> VK_DYNAMIC_STATE_SCISSOR) & 1;
+        if (_push_constant_layout != pipeline.layout) {
+            _push_constant_layout = nullptr;
+        }
         vkCmdBindPipeline(_handle, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.handle);
         return *this;
     }
 
-    CommandBuffer& CommandBuffer::bind_vertex_buffer(const Buffer& vertex) noexcept {
-        VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(_handle, 0, 1, &vertex.handle, &offset);
+    CommandBuffer& CommandBuffer::bind_compute_pipeline(const Pipeline& pipeline) noexcept {
+        qz_assert(pipeline.bind_point == VK_PIPELINE_BIND_POINT_COMPUTE, "Graphics pipelines are bound with bind_pipeline()");
+        if (_pipelines[1] == pipeline.handle) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _pipelines[1] = pipeline.handle;
+        if (_push_constant_layout != pipeline.layout) {
+            _push_constant_layout = nullptr;
+        }
+        vkCmdBindPipeline(_handle, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline.handle);
         return *this;
     }
 
-    CommandBuffer& CommandBuffer::bind_index_buffer(const Buffer& index) noexcept {
-        vkCmdBindIndexBuffer(_handle, index.handle, 0, VK_INDEX_TYPE_UINT32);
+    CommandBuffer& CommandBuffer::bind_descriptor_set(const Pipeline& pipeline, const std::uint32_t index, VkDescriptorSet set) noexcept {
+        // Pipelines sharing a layout share its handle, sets bound with it stay valid across them.
+        const auto bind_point = pipeline.bind_point == VK_PIPELINE_BIND_POINT_COMPUTE;
+        auto& bound_sets = _descriptor_sets[bind_point];
+        if (_layouts[bind_point] != pipeline.layout) {
+            _layouts[bind_point] = pipeline.layout;
+            bound_sets.fill(nullptr);
+        }
+        if (index < max_bound_descriptor_sets) {
+            if (bound_sets[index] == set) {
+                _elided_state_changes++;
+                return *this;
+            }
+            bound_sets[index] = set;
+        }
+        vkCmdBindDescriptorSets(_handle, pipeline.bind_point, pipeline.layout, index, 1, &set, 0, nullptr);
         return *this;
     }
 
-    CommandBuffer& CommandBuffer::bind_static_mesh(const StaticMesh& mesh) noexcept {
-        bind_vertex_buffer(mesh.geometry);
-        bind_index_buffer(mesh.indices);
+    CommandBuffer& CommandBuffer::bind_bindless_table(const Pipeline& pipeline, const std::uint32_t frame) noexcept {
+        return bind_descriptor_set(pipeline, bindless_set, bindless_descriptor_set(frame));
+    }
+
+    CommandBuffer& CommandBuffer::push_constants(const Pipeline& pipeline, const void* data, const std::uint32_t size) noexcept {
+        qz_assert(pipeline.push_constant_stages != 0, "Pipeline has no push constants");
+        qz_assert(size <= max_push_constant_size, "Push constants exceed the guaranteed range");
+        if (_push_constant_layout == pipeline.layout &&
+            _push_constant_size == size &&
+            std::memcmp(_push_constants.data(), data, size) == 0) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _push_constant_layout = pipeline.layout;
+        _push_constant_size = size;
+        std::memcpy(_push_constants.data(), data, size);
+        vkCmdPushConstants(_handle, pipeline.layout, pipeline.push_constant_stages, 0, size, data);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::bind_vertex_buffer(const Buffer& vertex, const std::uint32_t binding, const std::size_t offset) noexcept {
+        qz_assert(binding < max_vertex_bindings, "Vertex binding out of range");
+        if (_vertex_buffers[binding] == vertex.handle && _vertex_offsets[binding] == offset) {
+            _elided_state_changes++;
+            return *this;
+        }
+        if (binding == 0) {
+            _geometry_block = -1;
+        }
+        _vertex_buffers[binding] = vertex.handle;
+        _vertex_offsets[binding] = offset;
+        const VkDeviceSize vertex_offset = offset;
+        vkCmdBindVertexBuffers(_handle, binding, 1, &vertex.handle, &vertex_offset);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::bind_index_buffer(const Buffer& index, const VkIndexType index_type) noexcept {
+        if (_index_buffer == index.handle && _index_type == index_type) {
+            _elided_state_changes++;
+            return *this;
+        }
+        _geometry_block = -1;
+        _index_buffer = index.handle;
+        _index_type = index_type;
+        vkCmdBindIndexBuffer(_handle, index.handle, 0, index_type);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::bind_geometry_block(const std::uint32_t index, const VkIndexType index_type) noexcept {
+        // Every mesh in a block shares the same buffers, skip the block lookup when nothing changes.
+        if (_geometry_block == index && _index_type == index_type) {
+            _elided_state_changes += 2;
+            return *this;
+        }
+        const auto& block = geometry_block(index);
+        bind_vertex_buffer(block.vertices);
+        bind_index_buffer(block.indices, index_type);
+        _geometry_block = index;
         return *this;
     }
 
+    CommandBuffer& CommandBuffer::bind_static_mesh(const StaticMesh& mesh) noexcept {
+        return bind_geometry_block(mesh.geometry.block, mesh.index_type);
+    }
+
     CommandBuffer& CommandBuffer::draw(const std::uint32_t vertices,
                                        const std::uint32_t instances,
                                        const std::uint32_t first_vertex,
@@ -128,10 +272,61 @@ namespace qz::gfx {
     }
 
     CommandBuffer& CommandBuffer::draw_indexed(const std::uint32_t indices,
-                                const std::uint32_t instances,
-                                const std::uint32_t first_index,
-                                const std::uint32_t first_instance) noexcept {
-        vkCmdDrawIndexed(_handle, indices, instances, first_index, 0, first_instance);
+                                               const std::uint32_t instances,
+                                               const std::uint32_t first_index,
+                                               const std::int32_t vertex_offset,
+                                               const std::uint32_t first_instance) noexcept {
+        vkCmdDrawIndexed(_handle, indices, instances, first_index, vertex_offset, first_instance);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::draw_static_mesh(const StaticMesh& mesh,
+                                                   const std::uint32_t instances,
+                                                   const std::uint32_t first_instance,
+                                                   const std::uint32_t lod) noexcept {
+        qz_assert(lod < mesh.lod_count, "Level of detail out of range");
+        const auto& range = mesh.lods[lod];
+        return bind_static_mesh(mesh)
+            .draw_indexed(range.index_count, instances, range.first_index, mesh.vertex_offset, first_instance);
+    }
+
+    CommandBuffer& CommandBuffer::draw_indexed_indirect_count(const Buffer& commands,
+                                                              const std::size_t offset,
+                                                              const Buffer& count,
+                                                              const std::size_t count_offset,
+                                                              const std::uint32_t max_draws) noexcept {
+        vkCmdDrawIndexedIndirectCount(
+            _handle,
+            commands.handle, offset,
+            count.handle, count_offset,
+            max_draws, sizeof(VkDrawIndexedIndirectCommand));
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::dispatch(const std::uint32_t x, const std::uint32_t y, const std::uint32_t z) noexcept {
+        vkCmdDispatch(_handle, x, y, z);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::dispatch_indirect(const Buffer& buffer, const std::size_t offset) noexcept {
+        vkCmdDispatchIndirect(_handle, buffer.handle, offset);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::execute_commands(const std::span<const CommandBuffer> command_buffers) noexcept {
+        std::vector<VkCommandBuffer> handles;
+        handles.reserve(command_buffers.size());
+        for (const auto& each : command_buffers) {
+            handles.emplace_back(each.handle());
+        }
+        vkCmdExecuteCommands(_handle, handles.size(), handles.data());
+        forget_state();
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::next_subpass(const VkSubpassContents contents) noexcept {
+        qz_assert(_active_pass, "No active renderpass at next_subpass()");
+        vkCmdNextSubpass(_handle, contents);
         return *this;
     }
 
@@ -176,6 +371,16 @@ namespace qz::gfx {
         return *this;
     }
 
+    CommandBuffer& CommandBuffer::fill_buffer(const Buffer& buffer, const std::uint32_t value, const std::size_t offset, const std::size_t size) noexcept {
+        vkCmdFillBuffer(_handle, buffer.handle, offset, size, value);
+        return *this;
+    }
+
+    CommandBuffer& CommandBuffer::update_buffer(const Buffer& buffer, const void* data, const std::size_t size, const std::size_t offset) noexcept {
+        vkCmdUpdateBuffer(_handle, buffer.handle, offset, size, data);
+        return *this;
+    }
+
     CommandBuffer& CommandBuffer::insert_layout_transition(const ImageMemoryBarrier& info) noexcept {
         VkImageMemoryBarrier barrier{};
         barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -205,7 +410,35 @@ namespace qz::gfx {
         return *this;
     }
 
+    CommandBuffer& CommandBuffer::insert_buffer_barrier(const BufferMemoryBarrier& info) noexcept {
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = info.source_access;
+        barrier.dstAccessMask = info.dest_access;
+        barrier.srcQueueFamilyIndex = info.source_family;
+        barrier.dstQueueFamilyIndex = info.dest_family;
+        barrier.buffer = info.buffer->handle;
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+        vkCmdPipelineBarrier(
+            _handle,
+            info.source_stage,
+            info.dest_stage,
+            VkDependencyFlags{},
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
+        return *this;
+    }
+
     void CommandBuffer::end() noexcept {
+        elided_state_changes.fetch_add(_elided_state_changes, std::memory_order_relaxed);
+        _elided_state_changes = 0;
         qz_vulkan_check(vkEndCommandBuffer(_handle));
     }
+
+    qz_nodiscard std::uint64_t take_elided_state_changes() noexcept {
+        return elided_state_changes.exchange(0, std::memory_order_relaxed);
+    }
 } // namespace qz::gfx
\ No newline at end of file
@@ -8,6 +8,9 @@
 
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <span>
+
 namespace qz::gfx {
     struct ImageMemoryBarrier {
         const Image* image;
@@ -21,14 +24,53 @@ namespace qz::gfx {
         VkImageLayout new_layout;
     };
 
+    struct BufferMemoryBarrier {
+        const Buffer* buffer;
+        std::uint32_t source_family;
+        std::uint32_t dest_family;
+        VkPipelineStageFlags source_stage;
+        VkPipelineStageFlags dest_stage;
+        VkAccessFlags source_access;
+        VkAccessFlags dest_access;
+    };
+
+    // Descriptor sets tracked per command buffer, binds of higher sets are never filtered.
+    constexpr auto max_bound_descriptor_sets = 4;
+    // Vertex bindings tracked per command buffer, per-vertex data and per-instance data.
+    constexpr auto max_vertex_bindings = 2;
+    // Largest push constant range the filter remembers, the minimum every device guarantees.
+    constexpr auto max_push_constant_size = 128;
+
     class CommandBuffer {
         const RenderPass* _active_pass;
         VkCommandBuffer _handle;
         VkCommandPool _pool;
+        // State last recorded, binds and sets matching it are skipped. Everything is forgotten
+        // whenever recording begins or secondaries are executed, since their state doesn't carry over.
+        // Geometry block currently bound as vertex and index buffer, -1 if none.
+        std::uint32_t _geometry_block;
+        VkIndexType _index_type;
+        std::array<VkBuffer, max_vertex_bindings> _vertex_buffers;
+        std::array<std::size_t, max_vertex_bindings> _vertex_offsets;
+        VkBuffer _index_buffer;
+        // Pipelines, layouts and descriptor sets last bound to the graphics and compute bind points.
+        std::array<VkPipeline, 2> _pipelines;
+        std::array<VkPipelineLayout, 2> _layouts;
+        std::array<std::array<VkDescriptorSet, max_bound_descriptor_sets>, 2> _descriptor_sets;
+        VkViewport _viewport;
+        VkRect2D _scissor;
+        bool _has_viewport;
+        bool _has_scissor;
+        VkPipelineLayout _push_constant_layout;
+        std::uint32_t _push_constant_size;
+        std::array<std::uint8_t, max_push_constant_size> _push_constants;
+        std::uint32_t _elided_state_changes;
+
+        void forget_state() noexcept;
     public:
         CommandBuffer() noexcept = default;
 
-        qz_nodiscard static CommandBuffer allocate(const Context&, VkCommandPool) noexcept;
+        qz_nodiscard static CommandBuffer allocate(const Context&, VkCommandPool, VkCommandBufferLevel = VK_COMMAND_BUFFER_LEVEL_PRIMARY) noexcept;
         qz_nodiscard static CommandBuffer from_raw(VkCommandPool, VkCommandBuffer) noexcept;
         static void destroy(const Context&, CommandBuffer&) noexcept;
 
@@ -37,21 +79,46 @@ namespace qz::gfx {
         qz_nodiscard const VkCommandBuffer* ptr_handle() const noexcept;
 
         CommandBuffer& begin() noexcept;
-        CommandBuffer& begin_render_pass(const RenderPass&, std::size_t) noexcept;
+        // Begins a secondary command buffer that continues the first subpass of the given render pass.
+        CommandBuffer& begin_secondary(const RenderPass&, std::size_t, std::uint32_t = 0) noexcept;
+        CommandBuffer& begin_render_pass(const RenderPass&, std::size_t, VkSubpassContents = VK_SUBPASS_CONTENTS_INLINE) noexcept;
         CommandBuffer& set_viewport(meta::viewport_tag_t) noexcept;
         CommandBuffer& set_viewport(VkViewport) noexcept;
         CommandBuffer& set_scissor(meta::scissor_tag_t) noexcept;
         CommandBuffer& set_scissor(VkRect2D) noexcept;
         CommandBuffer& bind_pipeline(const Pipeline&) noexcept;
-        CommandBuffer& bind_vertex_buffer(const Buffer&) noexcept;
-        CommandBuffer& bind_index_buffer(const Buffer&) noexcept;
+        CommandBuffer& bind_compute_pipeline(const Pipeline&) noexcept;
+        CommandBuffer& bind_descriptor_set(const Pipeline&, std::uint32_t, VkDescriptorSet) noexcept;
+        // Binds the given frame's copy of the bindless table to its reserved set, it stays bound across pipelines sharing the layout.
+        CommandBuffer& bind_bindless_table(const Pipeline&, std::uint32_t) noexcept;
+        CommandBuffer& push_constants(const Pipeline&, const void*, std::uint32_t) noexcept;
+        CommandBuffer& bind_vertex_buffer(const Buffer&, std::uint32_t = 0, std::size_t = 0) noexcept;
+        CommandBuffer& bind_index_buffer(const Buffer&, VkIndexType = VK_INDEX_TYPE_UINT32) noexcept;
+        CommandBuffer& bind_geometry_block(std::uint32_t, VkIndexType = VK_INDEX_TYPE_UINT32) noexcept;
         CommandBuffer& bind_static_mesh(const StaticMesh&) noexcept;
         CommandBuffer& draw(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t) noexcept;
-        CommandBuffer& draw_indexed(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t) noexcept;
+        CommandBuffer& draw_indexed(std::uint32_t, std::uint32_t, std::uint32_t, std::int32_t, std::uint32_t) noexcept;
+        CommandBuffer& draw_static_mesh(const StaticMesh&, std::uint32_t, std::uint32_t, std::uint32_t = 0) noexcept;
+        // Reads the draw count from the second buffer, at most the given number of tightly packed commands are executed.
+        CommandBuffer& draw_indexed_indirect_count(const Buffer&, std::size_t, const Buffer&, std::size_t, std::uint32_t) noexcept;
+        CommandBuffer& dispatch(std::uint32_t, std::uint32_t = 1, std::uint32_t = 1) noexcept;
+        // Reads a VkDispatchIndirectCommand at the given offset.
+        CommandBuffer& dispatch_indirect(const Buffer&, std::size_t = 0) noexcept;
+        CommandBuffer& execute_commands(std::span<const CommandBuffer>) noexcept;
+        CommandBuffer& next_subpass(VkSubpassContents = VK_SUBPASS_CONTENTS_INLINE) noexcept;
         CommandBuffer& end_render_pass() noexcept;
         CommandBuffer& copy_image(const Image&, const Image&) noexcept;
         CommandBuffer& copy_buffer(const Buffer&, const Buffer&) noexcept;
+        CommandBuffer& fill_buffer(const Buffer&, std::uint32_t, std::size_t = 0, std::size_t = VK_WHOLE_SIZE) noexcept;
+        // Inline data of at most 65536 bytes, the size and offset must be multiples of 4.
+        CommandBuffer& update_buffer(const Buffer&, const void*, std::size_t, std::size_t = 0) noexcept;
         CommandBuffer& insert_layout_transition(const ImageMemoryBarrier&) noexcept;
+        CommandBuffer& insert_buffer_barrier(const BufferMemoryBarrier&) noexcept;
+        // Ends recording and adds the command buffer's elided state changes to the global count.
         void end() noexcept;
     };
+
+    // Number of binds, dynamic state sets and push constant updates skipped by every command buffer
+    // ended since the last call, which resets it.
+    qz_nodiscard std::uint64_t take_elided_state_changes() noexcept;
 } // namespace qz::gfx
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <qz/gfx/reflection.hpp>
 #include <qz/gfx/context.hpp>
 #include <qz/gfx/window.hpp>
 
@@ -68,16 +69,47 @@ namespace qz::gfx {
         });
     }
 
+    // Unlike the query above, missing extensions aren't reported since the caller can do without them.
+    qz_nodiscard static bool is_device_extension_supported(VkPhysicalDevice gpu, const char* name) noexcept {
+        std::uint32_t count;
+        qz_vulkan_check(vkEnumerateDeviceExtensionProperties(gpu, nullptr, &count, nullptr));
+        std::vector<VkExtensionProperties> available(count);
+        qz_vulkan_check(vkEnumerateDeviceExtensionProperties(gpu, nullptr, &count, available.data()));
+        return std::any_of(available.begin(), available.end(), [name](const auto& current) noexcept {
+            return std::strcmp(name, current.extensionName) == 0;
+        });
+    }
+
     qz_nodiscard static bool is_graphics_card_suitable(VkPhysicalDevice gpu) noexcept {
         // Query for card's available properties and features
         VkPhysicalDeviceProperties properties;
         vkGetPhysicalDeviceProperties(gpu, &properties);
 
-        VkPhysicalDeviceFeatures features;
-        vkGetPhysicalDeviceFeatures(gpu, &features);
+        VkPhysicalDeviceVulkan12Features vulkan12_features{};
+        vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features{};
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &vulkan12_features;
+        vkGetPhysicalDeviceFeatures2(gpu, &features);
+
+        // Every feature the device is created with must be supported.
+        const auto supported =
+            features.features.multiDrawIndirect &&
+            features.features.textureCompressionBC &&
+            vulkan12_features.timelineSemaphore &&
+            vulkan12_features.bufferDeviceAddress &&
+            vulkan12_features.drawIndirectCount &&
+            vulkan12_features.descriptorIndexing &&
+            vulkan12_features.runtimeDescriptorArray &&
+            vulkan12_features.descriptorBindingPartiallyBound &&
+            vulkan12_features.descriptorBindingUpdateUnusedWhilePending &&
+            vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind &&
+            vulkan12_features.descriptorBindingSampledImageUpdateAfterBind &&
+            vulkan12_features.shaderStorageBufferArrayNonUniformIndexing &&
+            vulkan12_features.shaderSampledImageArrayNonUniformIndexing;
 
         // Device is suitable if it's a discrete graphics card
-        return properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
+        return supported && properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU;
     }
 
     qz_nodiscard Context Context::create(const Settings& settings) noexcept {
@@ -189,7 +221,9 @@ namespace qz::gfx {
                 break;
             }
         }
-        qz_assert(context.gpu, "Failed to find a suitable graphics gard");
+        if (!context.gpu) {
+            qz_force_assert("Failed to find a suitable graphics card");
+        }
 
         // Pick queue family.
         // Query for all available queue families.
@@ -209,35 +243,90 @@ namespace qz::gfx {
 
         qz_assert(context.family != -1u, "No suitable queue family found");
 
+        // Async compute prefers a compute-only family, whose queues run alongside graphics on most hardware.
+        for (std::uint32_t index = 0; const auto& family : queue_properties) {
+            if ((family.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(family.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                context.compute_family = index;
+                break;
+            }
+            index++;
+        }
+
         // Create logical device.
-        constexpr std::array priorities = { 1.0f, 0.9f };
-        VkDeviceQueueCreateInfo queue_create_info{};
-        queue_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queue_create_info.queueFamilyIndex = context.family;
-        queue_create_info.queueCount = priorities.size();
-        queue_create_info.pQueuePriorities = priorities.data();
-
-        const std::vector<const char*> enabled_extensions{
+        // Graphics and transfer queues, plus a third one for compute if there's no dedicated family but room for it.
+        constexpr std::array priorities = { 1.0f, 0.9f, 0.9f };
+        const auto shares_family =
+            context.compute_family == -1u &&
+            queue_properties[context.family].queueCount >= priorities.size();
+        std::vector<VkDeviceQueueCreateInfo> queue_create_infos(1);
+        queue_create_infos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_create_infos[0].queueFamilyIndex = context.family;
+        queue_create_infos[0].queueCount = shares_family ? 3 : 2;
+        queue_create_infos[0].pQueuePriorities = priorities.data();
+        if (context.compute_family != -1u) {
+            queue_create_infos.push_back({
+                .sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+                .queueFamilyIndex = context.compute_family,
+                .queueCount = 1,
+                .pQueuePriorities = &priorities[2]
+            });
+        }
+
+        std::vector<const char*> enabled_extensions{
             VK_KHR_SWAPCHAIN_EXTENSION_NAME
         };
 
         qz_assert(query_device_extension_availability(context.gpu, enabled_extensions),
                   "One or more required device extensions are not available");
 
+        // Lets VMA report how much memory the process may use, texture streaming falls back to a fixed budget without it.
+        context.memory_budget = is_device_extension_supported(context.gpu, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (context.memory_budget) {
+            enabled_extensions.emplace_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        // Timeline semaphores are used to track completion of batched uploads, device addresses
+        // and indirect counts by the compute culling pass generating draws on the GPU.
+        // Descriptor indexing backs the bindless table, which is updated while frames using it are in flight.
+        VkPhysicalDeviceVulkan12Features vulkan12_features{};
+        vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12_features.timelineSemaphore = true;
+        vulkan12_features.bufferDeviceAddress = true;
+        vulkan12_features.drawIndirectCount = true;
+        vulkan12_features.descriptorIndexing = true;
+        vulkan12_features.runtimeDescriptorArray = true;
+        vulkan12_features.descriptorBindingPartiallyBound = true;
+        vulkan12_features.descriptorBindingUpdateUnusedWhilePending = true;
+        vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = true;
+        vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = true;
+        vulkan12_features.shaderStorageBufferArrayNonUniformIndexing = true;
+        vulkan12_features.shaderSampledImageArrayNonUniformIndexing = true;
+
+        // Block compressed formats are what texture files mostly store.
+        VkPhysicalDeviceFeatures device_features{};
+        device_features.multiDrawIndirect = true;
+        device_features.textureCompressionBC = true;
+
         VkDeviceCreateInfo device_create_info{};
         device_create_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        device_create_info.queueCreateInfoCount = 1;
-        device_create_info.pQueueCreateInfos = &queue_create_info;
+        device_create_info.pNext = &vulkan12_features;
+        device_create_info.queueCreateInfoCount = queue_create_infos.size();
+        device_create_info.pQueueCreateInfos = queue_create_infos.data();
         device_create_info.enabledLayerCount = 0;
         device_create_info.ppEnabledLayerNames = nullptr;
         device_create_info.enabledExtensionCount = enabled_extensions.size();
         device_create_info.ppEnabledExtensionNames = enabled_extensions.data();
-        device_create_info.pEnabledFeatures = nullptr;
-        qz_vulkan_check(vkCreateDevice(context.gpu, &device_create_info, nullptr, &context.device));
+        device_create_info.pEnabledFeatures = &device_features;
+        if (vkCreateDevice(context.gpu, &device_create_info, nullptr, &context.device) != VK_SUCCESS) {
+            qz_force_assert("Failed to create the logical device");
+        }
 
         // Create VmaAllocator.
         VmaAllocatorCreateInfo allocator_create_info{};
-        allocator_create_info.flags = {};
+        allocator_create_info.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+        if (context.memory_budget) {
+            allocator_create_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+        }
         allocator_create_info.instance = context.instance;
         allocator_create_info.device = context.device;
         allocator_create_info.physicalDevice = context.gpu;
@@ -253,19 +342,26 @@ namespace qz::gfx {
         // And retrieve queues.
         vkGetDeviceQueue(context.device, context.family, 0, &context.graphics);
         vkGetDeviceQueue(context.device, context.family, 1, &context.transfer);
+        if (context.compute_family != -1u) {
+            vkGetDeviceQueue(context.device, context.compute_family, 0, &context.compute);
+        } else if (shares_family) {
+            context.compute_family = context.family;
+            vkGetDeviceQueue(context.device, context.family, 2, &context.compute);
+        } else {
+            // No queue to spare, async compute degrades to submitting on the graphics queue.
+            context.compute_family = context.family;
+            context.compute = context.graphics;
+        }
 
-        // Create main command pool, used for allocating rendering command buffers.
-        VkCommandPoolCreateInfo command_pool_create_info{};
-        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        command_pool_create_info.queueFamilyIndex = context.family;
-        qz_vulkan_check(vkCreateCommandPool(context.device, &command_pool_create_info, nullptr, &context.main_pool));
+        // Load pipelines compiled by previous runs.
+        context.pipeline_cache = PipelineCache::create(context, settings.pipeline_cache);
 
         return context;
     }
 
     void Context::destroy(Context& context) noexcept {
-        vkDestroyCommandPool(context.device, context.main_pool, nullptr);
+        PipelineCache::destroy(context, context.pipeline_cache);
+        destroy_reflection(context);
         vmaDestroyAllocator(context.allocator);
         vkDestroyDevice(context.device, nullptr);
 #if defined(QUARTZ_DEBUG)
@@ -5,6 +5,7 @@
 #include <vulkan/vulkan.h>
 #include <vk_mem_alloc.h>
 
+#include <qz/gfx/pipeline_cache.hpp>
 #include <qz/util/macros.hpp>
 #include <qz/util/fwd.hpp>
 
@@ -14,6 +15,8 @@
 namespace qz::gfx {
     struct Settings {
         std::uint32_t version = VK_MAKE_VERSION(1, 2, 0);
+        // Where compiled pipelines are kept between runs.
+        const char* pipeline_cache = "quartz.pipeline_cache";
         // TODO: Maybe more settings?
     };
 
@@ -27,8 +30,13 @@ namespace qz::gfx {
         VmaAllocator allocator;
         VkQueue graphics;
         VkQueue transfer;
+        // May alias the graphics queue if the device has no queue to spare.
+        VkQueue compute;
         std::uint32_t family = -1;
-        VkCommandPool main_pool;
+        std::uint32_t compute_family = -1;
+        // Whether VK_EXT_memory_budget is enabled, vmaGetBudget reports the OS budget instead of an estimate.
+        bool memory_budget;
+        PipelineCache pipeline_cache;
 
         qz_nodiscard static Context create(const Settings& = {}) noexcept;
         static void destroy(Context&) noexcept;
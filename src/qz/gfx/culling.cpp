@@ -0,0 +1,190 @@
+#include <qz/gfx/culling.hpp>
+
+#include <qz/task/scheduler.hpp>
+
+#include <ftl/wait_group.h>
+
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define QUARTZ_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace qz::gfx {
+    // Instances per task, large enough for the scheduling overhead to vanish next to the tests.
+    constexpr auto culling_chunk = static_cast<std::size_t>(8192);
+
+    qz_nodiscard Frustum Frustum::from_matrix(const float* matrix) noexcept {
+        const auto row = [matrix](const std::uint32_t index) noexcept {
+            return std::array<float, 4>{ matrix[index], matrix[4 + index], matrix[8 + index], matrix[12 + index] };
+        };
+        const auto combine = [](const std::array<float, 4>& lhs, const std::array<float, 4>& rhs, const float sign) noexcept {
+            return std::array<float, 4>{ lhs[0] + sign * rhs[0], lhs[1] + sign * rhs[1], lhs[2] + sign * rhs[2], lhs[3] + sign * rhs[3] };
+        };
+        const auto x = row(0);
+        const auto y = row(1);
+        const auto z = row(2);
+        const auto w = row(3);
+
+        Frustum frustum{};
+        frustum.planes = {
+            combine(w, x, 1.0f),
+            combine(w, x, -1.0f),
+            combine(w, y, 1.0f),
+            combine(w, y, -1.0f),
+            z,
+            combine(w, z, -1.0f)
+        };
+        // Normalized so distances compare against radii and extents directly.
+        for (auto& plane : frustum.planes) {
+            const auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+            for (auto& each : plane) {
+                each /= length;
+            }
+        }
+        return frustum;
+    }
+
+    void InstanceBounds::push_back(const MeshBounds& bounds) noexcept {
+        center_x.push_back(bounds.center[0]);
+        center_y.push_back(bounds.center[1]);
+        center_z.push_back(bounds.center[2]);
+        radius.push_back(bounds.radius);
+        extent_x.push_back((bounds.max[0] - bounds.min[0]) * 0.5f);
+        extent_y.push_back((bounds.max[1] - bounds.min[1]) * 0.5f);
+        extent_z.push_back((bounds.max[2] - bounds.min[2]) * 0.5f);
+    }
+
+    void InstanceBounds::push_back(const MeshBounds& bounds, const std::array<float, 4>& transform) noexcept {
+        const auto scale = transform[3];
+        center_x.push_back(bounds.center[0] * scale + transform[0]);
+        center_y.push_back(bounds.center[1] * scale + transform[1]);
+        center_z.push_back(bounds.center[2] * scale + transform[2]);
+        radius.push_back(bounds.radius * scale);
+        extent_x.push_back((bounds.max[0] - bounds.min[0]) * 0.5f * scale);
+        extent_y.push_back((bounds.max[1] - bounds.min[1]) * 0.5f * scale);
+        extent_z.push_back((bounds.max[2] - bounds.min[2]) * 0.5f * scale);
+    }
+
+    void InstanceBounds::clear() noexcept {
+        center_x.clear();
+        center_y.clear();
+        center_z.clear();
+        radius.clear();
+        extent_x.clear();
+        extent_y.clear();
+        extent_z.clear();
+    }
+
+    qz_nodiscard std::size_t InstanceBounds::size() const noexcept {
+        return center_x.size();
+    }
+
+    qz_nodiscard static bool is_visible(const Frustum& frustum, const InstanceBounds& bounds, const std::size_t i) noexcept {
+        for (const auto& plane : frustum.planes) {
+            const auto distance = plane[0] * bounds.center_x[i] + plane[1] * bounds.center_y[i] + plane[2] * bounds.center_z[i] + plane[3];
+            const auto projected =
+                std::abs(plane[0]) * bounds.extent_x[i] +
+                std::abs(plane[1]) * bounds.extent_y[i] +
+                std::abs(plane[2]) * bounds.extent_z[i];
+            if (distance < -bounds.radius[i] || distance < -projected) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Writes the visible indices of [begin, end) starting at output, returns how many were written.
+    static std::size_t cull_range(const Frustum& frustum, const InstanceBounds& bounds, const std::size_t begin, const std::size_t end, std::uint32_t* output) noexcept {
+        auto count = static_cast<std::size_t>(0);
+        auto i = begin;
+#if defined(QUARTZ_SSE2)
+        const auto sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+        for (; i + 4 <= end; i += 4) {
+            const auto center_x = _mm_loadu_ps(&bounds.center_x[i]);
+            const auto center_y = _mm_loadu_ps(&bounds.center_y[i]);
+            const auto center_z = _mm_loadu_ps(&bounds.center_z[i]);
+            const auto radius = _mm_loadu_ps(&bounds.radius[i]);
+            const auto extent_x = _mm_loadu_ps(&bounds.extent_x[i]);
+            const auto extent_y = _mm_loadu_ps(&bounds.extent_y[i]);
+            const auto extent_z = _mm_loadu_ps(&bounds.extent_z[i]);
+
+            // Both tests are conservative, an instance is culled as soon as either is fully outside a plane.
+            auto visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (const auto& plane : frustum.planes) {
+                const auto distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), center_x), _mm_mul_ps(_mm_set1_ps(plane[1]), center_y)),
+                    _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), center_z), _mm_set1_ps(plane[3])));
+                const auto projected = _mm_add_ps(
+                    _mm_add_ps(
+                        _mm_mul_ps(_mm_and_ps(_mm_set1_ps(plane[0]), sign_mask), extent_x),
+                        _mm_mul_ps(_mm_and_ps(_mm_set1_ps(plane[1]), sign_mask), extent_y)),
+                    _mm_mul_ps(_mm_and_ps(_mm_set1_ps(plane[2]), sign_mask), extent_z));
+                const auto negative = _mm_sub_ps(_mm_setzero_ps(), distance);
+                visible = _mm_and_ps(visible, _mm_cmple_ps(negative, radius));
+                visible = _mm_and_ps(visible, _mm_cmple_ps(negative, projected));
+            }
+
+            // Branchless compaction: every lane is written, only visible ones advance the cursor.
+            const auto mask = _mm_movemask_ps(visible);
+            for (std::uint32_t lane = 0; lane < 4; ++lane) {
+                output[count] = i + lane;
+                count += (mask >> lane) & 1;
+            }
+        }
+#endif
+        for (; i < end; ++i) {
+            output[count] = i;
+            count += is_visible(frustum, bounds, i);
+        }
+        return count;
+    }
+
+    struct CullingTask {
+        const Frustum* frustum;
+        const InstanceBounds* bounds;
+        std::uint32_t* output;
+        std::size_t begin;
+        std::size_t end;
+        std::size_t count;
+    };
+
+    void cull_instances(const Frustum& frustum, const InstanceBounds& bounds, std::vector<std::uint32_t>& visible) noexcept {
+        const auto size = bounds.size();
+        visible.resize(size);
+        if (size <= culling_chunk) {
+            visible.resize(cull_range(frustum, bounds, 0, size, visible.data()));
+            return;
+        }
+
+        // Every chunk writes to its own slice of the output, slices are compacted once all of them are done.
+        const auto chunks = (size + culling_chunk - 1) / culling_chunk;
+        std::vector<CullingTask> task_data(chunks);
+        std::vector<ftl::Task> tasks(chunks);
+        for (std::size_t i = 0; i < chunks; ++i) {
+            const auto begin = i * culling_chunk;
+            task_data[i] = { &frustum, &bounds, visible.data() + begin, begin, std::min(size, begin + culling_chunk), 0 };
+            tasks[i] = {
+                .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                    const auto data = static_cast<CullingTask*>(ptr);
+                    data->count = cull_range(*data->frustum, *data->bounds, data->begin, data->end, data->output);
+                },
+                .ArgData = &task_data[i]
+            };
+        }
+
+        ftl::WaitGroup wait_group(&task::get_scheduler());
+        task::get_scheduler().AddTasks(tasks.size(), tasks.data(), ftl::TaskPriority::High, &wait_group);
+        wait_group.Wait(true);
+
+        auto count = task_data[0].count;
+        for (std::size_t i = 1; i < chunks; ++i) {
+            std::memmove(visible.data() + count, task_data[i].output, task_data[i].count * sizeof(std::uint32_t));
+            count += task_data[i].count;
+        }
+        visible.resize(count);
+    }
+} // namespace qz::gfx
\ No newline at end of file
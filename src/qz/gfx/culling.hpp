@@ -0,0 +1,39 @@
+#pragma once
+
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <array>
+
+namespace qz::gfx {
+    // Planes point inwards: a point p is inside when dot(plane.xyz, p) + plane.w >= 0.
+    struct Frustum {
+        std::array<std::array<float, 4>, 6> planes;
+
+        // Extracts the planes from a column major view projection matrix with a [0, 1] depth range.
+        qz_nodiscard static Frustum from_matrix(const float*) noexcept;
+    };
+
+    // World space bounds stored as a structure of arrays, so four instances are tested per instruction.
+    struct InstanceBounds {
+        std::vector<float> center_x;
+        std::vector<float> center_y;
+        std::vector<float> center_z;
+        std::vector<float> radius;
+        std::vector<float> extent_x;
+        std::vector<float> extent_y;
+        std::vector<float> extent_z;
+
+        void push_back(const MeshBounds&) noexcept;
+        // Bounds of a mesh instance translated by xyz and uniformly scaled by w.
+        void push_back(const MeshBounds&, const std::array<float, 4>&) noexcept;
+        void clear() noexcept;
+        qz_nodiscard std::size_t size() const noexcept;
+    };
+
+    // Tests every instance's sphere and box against the frustum in parallel chunks on the scheduler
+    // and writes the indices of the visible ones, in order, into the output. Must be called from a task.
+    void cull_instances(const Frustum&, const InstanceBounds&, std::vector<std::uint32_t>&) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
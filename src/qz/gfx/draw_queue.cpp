@@ -0,0 +1,106 @@
+#include <qz/gfx/draw_queue.hpp>
+
+#include <algorithm>
+#include <array>
+
+namespace qz::gfx {
+    constexpr auto radix_bits = 8u;
+    constexpr auto radix_digits = 64u / radix_bits;
+    constexpr auto radix_buckets = 1u << radix_bits;
+
+    qz_nodiscard std::uint64_t make_draw_key(const std::uint32_t pass,
+                                             const std::uint32_t pipeline,
+                                             const std::uint32_t material,
+                                             const std::uint32_t mesh,
+                                             const float depth) noexcept {
+        if (pass > 0xf || pipeline > 0xfff || material > 0xffff || mesh > 0xffff) {
+            qz_force_assert("Draw key identifier does not fit its field");
+        }
+        const auto quantized = static_cast<std::uint64_t>(std::clamp(depth, 0.0f, 1.0f) * 65535.0f + 0.5f);
+        return
+            (static_cast<std::uint64_t>(pass) << 60) |
+            (static_cast<std::uint64_t>(pipeline) << 48) |
+            (static_cast<std::uint64_t>(material) << 32) |
+            (static_cast<std::uint64_t>(mesh) << 16) |
+            quantized;
+    }
+
+    qz_nodiscard std::uint32_t DrawIds::operator ()(const std::uint32_t index) noexcept {
+        if (index >= slots.size()) {
+            slots.resize(index + 1, 0);
+        }
+        if (!slots[index]) {
+            assigned.push_back(index);
+            slots[index] = assigned.size();
+        }
+        return slots[index] - 1;
+    }
+
+    void DrawIds::clear() noexcept {
+        for (const auto index : assigned) {
+            slots[index] = 0;
+        }
+        assigned.clear();
+    }
+
+    void DrawQueue::push(const std::uint64_t key, const std::uint32_t payload) noexcept {
+        items.push_back({ key, payload });
+    }
+
+    void DrawQueue::clear() noexcept {
+        items.clear();
+        pipelines.clear();
+        materials.clear();
+        meshes.clear();
+    }
+
+    void DrawQueue::sort() noexcept {
+        // Every histogram is built in a single pass over the keys.
+        std::array<std::array<std::uint32_t, radix_buckets>, radix_digits> histograms{};
+        for (const auto& each : items) {
+            for (std::uint32_t digit = 0; digit < radix_digits; ++digit) {
+                histograms[digit][(each.key >> (digit * radix_bits)) & (radix_buckets - 1)]++;
+            }
+        }
+
+        scratch.resize(items.size());
+        for (std::uint32_t digit = 0; digit < radix_digits; ++digit) {
+            auto& histogram = histograms[digit];
+            // A digit all keys share wouldn't move anything, which is the common case for the pass and pipeline bits.
+            if (std::any_of(histogram.begin(), histogram.end(), [this](const std::uint32_t count) {
+                return count == items.size();
+            })) {
+                continue;
+            }
+
+            std::uint32_t offset = 0;
+            for (auto& count : histogram) {
+                const auto current = count;
+                count = offset;
+                offset += current;
+            }
+            for (const auto& each : items) {
+                scratch[histogram[(each.key >> (digit * radix_bits)) & (radix_buckets - 1)]++] = each;
+            }
+            items.swap(scratch);
+        }
+    }
+
+    void DrawQueue::batch(std::vector<DrawBatch>& batches) const noexcept {
+        batches.clear();
+        for (std::uint32_t i = 0; i < items.size(); ++i) {
+            if (batches.empty() || (items[i].key >> 16) != (items[batches.back().first].key >> 16)) {
+                batches.push_back({ i, 0 });
+            }
+            batches.back().count++;
+        }
+    }
+
+    qz_nodiscard std::size_t DrawQueue::size() const noexcept {
+        return items.size();
+    }
+
+    qz_nodiscard const DrawItem& DrawQueue::operator [](const std::size_t index) const noexcept {
+        return items[index];
+    }
+} // namespace qz::gfx
\ No newline at end of file
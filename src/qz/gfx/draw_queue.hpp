@@ -0,0 +1,56 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <vector>
+
+namespace qz::gfx {
+    // Key fields from most to least significant: pass 4 bits, pipeline 12, material 16, mesh 16 and depth 16,
+    // so sorted draws change passes and pipelines as rarely as possible and go front to back within them.
+    // Identifiers must fit their field, batching would merge draws of identifiers that only differ in higher bits,
+    // so handle indices go through the queue's DrawIds first. Depth is clamped to [0, 1].
+    qz_nodiscard std::uint64_t make_draw_key(std::uint32_t, std::uint32_t, std::uint32_t, std::uint32_t, float) noexcept;
+
+    // Dense identifiers in the order indices are first seen since the last clear, however far handle indices grow.
+    struct DrawIds {
+        // Identifier plus one for every index seen so far, zero while unassigned.
+        std::vector<std::uint32_t> slots;
+        std::vector<std::uint32_t> assigned;
+
+        qz_nodiscard std::uint32_t operator ()(std::uint32_t) noexcept;
+        void clear() noexcept;
+    };
+
+    struct DrawItem {
+        std::uint64_t key;
+        // Whatever the caller needs to record the draw, usually an index into its own draw list.
+        std::uint32_t payload;
+    };
+
+    // Range of sorted items recorded as one instanced draw.
+    struct DrawBatch {
+        std::uint32_t first;
+        std::uint32_t count;
+    };
+
+    // Draws collected during a frame and sorted by key before recording.
+    struct DrawQueue {
+        std::vector<DrawItem> items;
+        std::vector<DrawItem> scratch;
+        DrawIds pipelines;
+        DrawIds materials;
+        DrawIds meshes;
+
+        void push(std::uint64_t, std::uint32_t) noexcept;
+        // Drops the items and the identifiers handed out for them.
+        void clear() noexcept;
+        // Stable LSD radix sort on 8 bit digits, digits every key shares are skipped.
+        void sort() noexcept;
+        // Groups consecutive items whose keys only differ in depth, each group draws the same mesh
+        // with the same pipeline and material, so it can become a single instanced call.
+        void batch(std::vector<DrawBatch>&) const noexcept;
+        qz_nodiscard std::size_t size() const noexcept;
+        qz_nodiscard const DrawItem& operator [](std::size_t) const noexcept;
+    };
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,104 @@
+#include <qz/gfx/geometry.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <qz/util/free_list.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <mutex>
+
+namespace qz::gfx {
+    constexpr auto max_geometry_blocks = 16u;
+    constexpr auto vertex_block_capacity = static_cast<std::size_t>(64 * 1024 * 1024);
+    constexpr auto index_block_capacity = static_cast<std::size_t>(32 * 1024 * 1024);
+
+    struct BlockAllocator {
+        util::FreeList vertices;
+        util::FreeList indices;
+    };
+
+    // Blocks live in a fixed array so the render thread can read them without locking while new ones are created.
+    static std::array<GeometryBlock, max_geometry_blocks> blocks;
+    static std::array<BlockAllocator, max_geometry_blocks> allocators;
+    static std::atomic<std::uint32_t> block_count;
+    static std::mutex allocator_mutex;
+
+    qz_nodiscard static std::uint32_t create_block(const Context& context, const std::size_t vertex_size, const std::size_t index_size) noexcept {
+        const auto index = block_count.load();
+        if (index >= max_geometry_blocks) {
+            qz_force_assert("Ran out of geometry blocks");
+        }
+
+        const auto vertex_capacity = std::max(vertex_size, vertex_block_capacity);
+        const auto index_capacity = std::max(index_size, index_block_capacity);
+        blocks[index] = {
+            // Also readable as a storage buffer through the bindless table, for vertex pulling.
+            Buffer::create(context, {
+                .flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = vertex_capacity
+            }),
+            Buffer::create(context, {
+                .flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = index_capacity
+            })
+        };
+        allocators[index] = {
+            util::FreeList(vertex_capacity),
+            util::FreeList(index_capacity)
+        };
+        block_count.store(index + 1);
+        return index;
+    }
+
+    qz_nodiscard GeometryAllocation allocate_geometry(const Context& context,
+                                                      const std::size_t vertex_size,
+                                                      const std::size_t vertex_stride,
+                                                      const std::size_t index_size,
+                                                      const std::size_t index_stride) noexcept {
+        std::lock_guard<std::mutex> lock(allocator_mutex);
+        const auto try_allocate = [&](const std::uint32_t block) noexcept -> std::optional<GeometryAllocation> {
+            auto& allocator = allocators[block];
+            const auto vertex_offset = allocator.vertices.allocate(vertex_size, vertex_stride);
+            if (!vertex_offset) {
+                return std::nullopt;
+            }
+            const auto index_offset = allocator.indices.allocate(index_size, index_stride);
+            if (!index_offset) {
+                allocator.vertices.free(*vertex_offset, vertex_size);
+                return std::nullopt;
+            }
+            return GeometryAllocation{ block, *vertex_offset, vertex_size, *index_offset, index_size };
+        };
+
+        for (std::uint32_t block = 0; block < block_count.load(); ++block) {
+            if (const auto allocation = try_allocate(block)) {
+                return *allocation;
+            }
+        }
+        return *try_allocate(create_block(context, vertex_size, index_size));
+    }
+
+    void free_geometry(const GeometryAllocation& allocation) noexcept {
+        std::lock_guard<std::mutex> lock(allocator_mutex);
+        auto& allocator = allocators[allocation.block];
+        allocator.vertices.free(allocation.vertex_offset, allocation.vertex_size);
+        allocator.indices.free(allocation.index_offset, allocation.index_size);
+    }
+
+    qz_nodiscard const GeometryBlock& geometry_block(const std::uint32_t index) noexcept {
+        qz_assert(index < block_count.load(), "Invalid geometry block");
+        return blocks[index];
+    }
+
+    void destroy_geometry(const Context& context) noexcept {
+        for (std::uint32_t block = 0; block < block_count.load(); ++block) {
+            Buffer::destroy(context, blocks[block].vertices);
+            Buffer::destroy(context, blocks[block].indices);
+            allocators[block] = {};
+        }
+        block_count.store(0);
+    }
+} // namespace qz::gfx
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/gfx/buffer.hpp>
+
+#include <cstdint>
+
+namespace qz::gfx {
+    // Large device local vertex and index buffers shared by every StaticMesh, a whole frame binds them once.
+    struct GeometryBlock {
+        Buffer vertices;
+        Buffer indices;
+    };
+
+    // Byte ranges of a mesh inside one of the geometry blocks.
+    struct GeometryAllocation {
+        std::uint32_t block;
+        std::size_t vertex_offset;
+        std::size_t vertex_size;
+        std::size_t index_offset;
+        std::size_t index_size;
+    };
+
+    // Suballocates vertex and index ranges from the same block, creating a new block if none has room.
+    // Vertex ranges are aligned to the stride so they can be addressed with vertexOffset.
+    qz_nodiscard GeometryAllocation allocate_geometry(const Context&, std::size_t, std::size_t, std::size_t, std::size_t) noexcept;
+    void free_geometry(const GeometryAllocation&) noexcept;
+    qz_nodiscard const GeometryBlock& geometry_block(std::uint32_t) noexcept;
+    void destroy_geometry(const Context&) noexcept;
+} // namespace qz::gfx
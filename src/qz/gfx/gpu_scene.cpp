@@ -0,0 +1,259 @@
+#include <qz/gfx/command_buffer.hpp>
+#include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/gpu_scene.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <qz/meta/constants.hpp>
+
+#include <cstddef>
+#include <cstring>
+
+namespace qz::gfx {
+    // Matches the workgroup size declared by the culling shader.
+    constexpr auto cull_group_size = 64u;
+
+    // Passes of the culling shader, recorded in this order.
+    constexpr auto cull_pass_classify = 0u;
+    constexpr auto cull_pass_emit = 1u;
+    constexpr auto cull_pass_scatter = 2u;
+
+    // Push constant block of the culling shader, the rest of its inputs live in the draw buffer's header to fit it.
+    struct CullConstants {
+        VkDeviceAddress meshes;
+        VkDeviceAddress instances;
+        VkDeviceAddress transforms;
+        VkDeviceAddress draws;
+        VkDeviceAddress bins;
+        VkDeviceAddress visible;
+        VkDeviceAddress compacted;
+        std::uint32_t pass;
+        std::uint32_t bin_count;
+    };
+    static_assert(sizeof(CullConstants) <= 128, "Culling constants must fit the guaranteed push constant range");
+
+    qz_nodiscard GpuScene GpuScene::create(const Context& context, CreateInfo&& info) noexcept {
+        GpuScene scene{};
+        scene.pipeline = Pipeline::create_compute(context, {
+            .compute = info.cull_shader
+        });
+        scene.meshes = Buffer::create(context, {
+            .flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .capacity = info.max_meshes * sizeof(GpuMesh),
+            .concurrent = true
+        });
+        scene.instances = Buffer::create(context, {
+            .flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .capacity = info.max_instances * sizeof(std::uint32_t),
+            .concurrent = true
+        });
+        scene.transforms = Buffer::create(context, {
+            .flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .capacity = info.max_instances * 4 * sizeof(float),
+            .concurrent = true
+        });
+        for (auto& each : scene.draws) {
+            each = Buffer::create(context, {
+                .flags =
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                    VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = gpu_draws_offset + max_gpu_scene_groups * info.max_instances * sizeof(VkDrawIndexedIndirectCommand),
+                .concurrent = true
+            });
+        }
+        for (auto& each : scene.bins) {
+            each = Buffer::create(context, {
+                .flags =
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                    VK_BUFFER_USAGE_TRANSFER_DST_BIT |
+                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = info.max_meshes * max_mesh_lods * sizeof(std::uint32_t),
+                .concurrent = true
+            });
+        }
+        for (auto& each : scene.visible) {
+            each = Buffer::create(context, {
+                .flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = info.max_instances * 2 * sizeof(std::uint32_t),
+                .concurrent = true
+            });
+        }
+        for (auto& each : scene.compacted) {
+            each = Buffer::create(context, {
+                .flags =
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+                    VK_BUFFER_USAGE_VERTEX_BUFFER_BIT |
+                    VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+                .usage = VMA_MEMORY_USAGE_GPU_ONLY,
+                .capacity = info.max_instances * 4 * sizeof(float),
+                .concurrent = true
+            });
+        }
+        scene.max_meshes = info.max_meshes;
+        scene.max_instances = info.max_instances;
+        return scene;
+    }
+
+    void GpuScene::destroy(const Context& context, GpuScene& scene) noexcept {
+        for (auto& each : scene.compacted) {
+            Buffer::destroy(context, each);
+        }
+        for (auto& each : scene.visible) {
+            Buffer::destroy(context, each);
+        }
+        for (auto& each : scene.bins) {
+            Buffer::destroy(context, each);
+        }
+        for (auto& each : scene.draws) {
+            Buffer::destroy(context, each);
+        }
+        Buffer::destroy(context, scene.transforms);
+        Buffer::destroy(context, scene.instances);
+        Buffer::destroy(context, scene.meshes);
+        Pipeline::destroy(context, scene.pipeline);
+        scene = {};
+    }
+
+    qz_nodiscard std::uint32_t GpuScene::add_mesh(const Context& context, const StaticMesh& mesh) noexcept {
+        if (mesh_count >= max_meshes) {
+            qz_force_assert("GPU scene mesh table is full");
+        }
+        auto group = 0u;
+        while (group < group_count && (groups[group].geometry_block != mesh.geometry.block || groups[group].index_type != mesh.index_type)) {
+            ++group;
+        }
+        if (group == group_count) {
+            if (group_count == max_gpu_scene_groups) {
+                qz_force_assert("GPU scene uses too many geometry blocks and index types");
+            }
+            groups[group_count++] = { mesh.geometry.block, mesh.index_type };
+        }
+
+        GpuMesh entry{
+            static_cast<std::int32_t>(mesh.vertex_offset),
+            mesh.lod_count,
+            group,
+            0,
+            { mesh.bounds.center[0], mesh.bounds.center[1], mesh.bounds.center[2], mesh.bounds.radius }
+        };
+        for (std::uint32_t i = 0; i < mesh.lod_count; ++i) {
+            entry.lods[i] = { mesh.lods[i].first_index, mesh.lods[i].index_count, mesh.lods[i].error, 0 };
+        }
+        const auto offset = mesh_count * sizeof(GpuMesh);
+        std::memcpy(static_cast<char*>(meshes.mapped) + offset, &entry, sizeof(GpuMesh));
+        vmaFlushAllocation(context.allocator, meshes.allocation, offset, sizeof(GpuMesh));
+        return mesh_count++;
+    }
+
+    qz_nodiscard std::uint32_t GpuScene::add_instance(const Context& context, const std::uint32_t mesh, const float (&position)[3], const float scale) noexcept {
+        if (instance_count >= max_instances) {
+            qz_force_assert("GPU scene instance table is full");
+        }
+        if (mesh >= mesh_count) {
+            qz_force_assert("Instance refers to a mesh that was never added");
+        }
+
+        const float transform[] = { position[0], position[1], position[2], scale };
+        const auto offset = instance_count * sizeof(transform);
+        std::memcpy(static_cast<char*>(transforms.mapped) + offset, transform, sizeof(transform));
+        vmaFlushAllocation(context.allocator, transforms.allocation, offset, sizeof(transform));
+
+        const auto mesh_offset = instance_count * sizeof(std::uint32_t);
+        std::memcpy(static_cast<char*>(instances.mapped) + mesh_offset, &mesh, sizeof(std::uint32_t));
+        vmaFlushAllocation(context.allocator, instances.allocation, mesh_offset, sizeof(std::uint32_t));
+        return instance_count++;
+    }
+
+    void GpuScene::cull(CommandBuffer& command_buffer, const Frustum& frustum, const LodSettings& lod, const std::uint32_t frame) const noexcept {
+        // Nothing is drawn without instances either, and an empty bin table can't be cleared.
+        if (instance_count == 0) {
+            return;
+        }
+        const auto& output = draws[frame];
+        GpuDrawsHeader header{
+            instance_count,
+            max_instances,
+            lod.projection_scale,
+            lod.pixels,
+            { lod.camera[0], lod.camera[1], lod.camera[2], 0.0f },
+            {},
+            {}
+        };
+        std::memcpy(header.planes, frustum.planes.data(), sizeof(header.planes));
+        CullConstants constants{
+            meshes.address,
+            instances.address,
+            transforms.address,
+            output.address,
+            bins[frame].address,
+            visible[frame].address,
+            compacted[frame].address,
+            cull_pass_classify,
+            mesh_count * max_mesh_lods
+        };
+        const auto instance_groups = (instance_count + cull_group_size - 1) / cull_group_size;
+        const auto compute_barrier = [](const Buffer& buffer, const VkPipelineStageFlags source_stage, const VkAccessFlags source_access) noexcept {
+            return BufferMemoryBarrier{
+                .buffer = &buffer,
+                .source_family = meta::family_ignored,
+                .dest_family = meta::family_ignored,
+                .source_stage = source_stage,
+                .dest_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .source_access = source_access,
+                .dest_access = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+            };
+        };
+
+        // The previous reader of these buffers is the frame that last used this slot, its fence was already waited on.
+        command_buffer
+            .update_buffer(output, &header, sizeof(header))
+            .fill_buffer(bins[frame], 0, 0, constants.bin_count * sizeof(std::uint32_t))
+            .insert_buffer_barrier(compute_barrier(output, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT))
+            .insert_buffer_barrier(compute_barrier(bins[frame], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT))
+            .bind_compute_pipeline(pipeline)
+            .push_constants(pipeline, &constants, sizeof(constants))
+            .dispatch(instance_groups)
+            .insert_buffer_barrier(compute_barrier(bins[frame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT))
+            .insert_buffer_barrier(compute_barrier(visible[frame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT));
+        // Offsets are scanned by a single workgroup.
+        constants.pass = cull_pass_emit;
+        command_buffer
+            .push_constants(pipeline, &constants, sizeof(constants))
+            .dispatch(1)
+            .insert_buffer_barrier(compute_barrier(bins[frame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT));
+        constants.pass = cull_pass_scatter;
+        command_buffer
+            .push_constants(pipeline, &constants, sizeof(constants))
+            .dispatch(instance_groups)
+            .insert_buffer_barrier({
+                .buffer = &output,
+                .source_family = meta::family_ignored,
+                .dest_family = meta::family_ignored,
+                .source_stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                .dest_stage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                .source_access = VK_ACCESS_SHADER_WRITE_BIT,
+                .dest_access = VK_ACCESS_INDIRECT_COMMAND_READ_BIT
+            });
+    }
+
+    void GpuScene::draw(CommandBuffer& command_buffer, const std::uint32_t frame) const noexcept {
+        if (instance_count == 0) {
+            return;
+        }
+        command_buffer.bind_vertex_buffer(compacted[frame], 1);
+        for (std::uint32_t i = 0; i < group_count; ++i) {
+            const auto commands = gpu_draws_offset + i * max_instances * sizeof(VkDrawIndexedIndirectCommand);
+            const auto count = offsetof(GpuDrawsHeader, counts) + i * sizeof(std::uint32_t);
+            command_buffer
+                .bind_geometry_block(groups[i].geometry_block, groups[i].index_type)
+                .draw_indexed_indirect_count(draws[frame], commands, draws[frame], count, max_instances);
+        }
+    }
+} // namespace qz::gfx
\ No newline at end of file
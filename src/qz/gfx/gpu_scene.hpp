@@ -0,0 +1,110 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/gfx/pipeline.hpp>
+#include <qz/gfx/culling.hpp>
+#include <qz/gfx/buffer.hpp>
+#include <qz/meta/types.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <array>
+
+namespace qz::gfx {
+    // Distinct geometry block and index type pairs a scene can draw, each one is drawn with its own call.
+    constexpr auto max_gpu_scene_groups = 8u;
+
+    // std430 layouts shared with data/shaders/cull.comp.
+    struct GpuLod {
+        std::uint32_t first_index;
+        std::uint32_t index_count;
+        float error;
+        std::uint32_t padding;
+    };
+
+    struct GpuMesh {
+        std::int32_t vertex_offset;
+        std::uint32_t lod_count;
+        // Draw group of the mesh's geometry block and index type.
+        std::uint32_t group;
+        std::uint32_t padding;
+        // Object space bounding sphere, center in xyz and radius in w.
+        float sphere[4];
+        GpuLod lods[max_mesh_lods];
+    };
+
+    // Header of every draw buffer, written before each culling pass. Push constants are full, so
+    // the instance count and level of detail settings are read from here.
+    struct GpuDrawsHeader {
+        std::uint32_t instance_count;
+        std::uint32_t max_instances;
+        float projection_scale;
+        float pixels;
+        float camera[4];
+        float planes[6][4];
+        // Commands written for each draw group.
+        std::uint32_t counts[max_gpu_scene_groups];
+    };
+
+    // The commands follow the header in every draw buffer, each draw group has room for max_instances of them.
+    constexpr auto gpu_draws_offset = sizeof(GpuDrawsHeader);
+
+    struct GpuDrawGroup {
+        std::uint32_t geometry_block;
+        VkIndexType index_type;
+    };
+
+    // Mesh ranges and instances kept in device addressable storage buffers. A compute pass culls every instance,
+    // picks the level of detail select_lod would and counts visible instances per mesh and level. One instanced
+    // indexed indirect command is written per non empty mesh and level, its visible transforms are compacted next
+    // to each other. Meshes are grouped by geometry block and index type, the scene is then drawn with one call per group.
+    struct GpuScene {
+        struct CreateInfo {
+            const char* cull_shader;
+            std::uint32_t max_meshes;
+            std::uint32_t max_instances;
+        };
+
+        Pipeline pipeline;
+        // Persistently mapped and only ever appended to, so frames in flight never see their entries change.
+        Buffer meshes;
+        // Mesh index of every instance.
+        Buffer instances;
+        // Translation in xyz and uniform scale in w of every instance.
+        Buffer transforms;
+        // Written by the culling pass of each frame in flight.
+        meta::in_flight_array<Buffer> draws;
+        // Visible instance count, then first compacted instance, of every mesh and level of detail.
+        meta::in_flight_array<Buffer> bins;
+        // Bin and slot within it of every instance.
+        meta::in_flight_array<Buffer> visible;
+        // Transforms of the visible instances in draw order, bound as per-instance vertex stream.
+        meta::in_flight_array<Buffer> compacted;
+        std::uint32_t mesh_count;
+        std::uint32_t instance_count;
+        std::uint32_t max_meshes;
+        std::uint32_t max_instances;
+        std::array<GpuDrawGroup, max_gpu_scene_groups> groups;
+        std::uint32_t group_count;
+
+        qz_nodiscard static GpuScene create(const Context&, CreateInfo&&) noexcept;
+        static void destroy(const Context&, GpuScene&) noexcept;
+
+        // Returns the index instances refer to the mesh with, every level of detail is added.
+        qz_nodiscard std::uint32_t add_mesh(const Context&, const StaticMesh&) noexcept;
+        // Returns the instance's index, its transform is copied next to its batch by every culling pass.
+        qz_nodiscard std::uint32_t add_instance(const Context&, std::uint32_t, const float (&)[3], float = 1.0f) noexcept;
+
+        // Records the culling pass for the given frame in flight outside of a render pass, on the async compute queue.
+        // The graphics submission waits for it at the draw indirect stage, which also covers the compacted transforms.
+        void cull(CommandBuffer&, const Frustum&, const LodSettings&, std::uint32_t) const noexcept;
+        // Draws whatever survived the frame's culling pass with the currently bound graphics pipeline,
+        // which takes a single vec4 instance attribute.
+        void draw(CommandBuffer&, std::uint32_t) const noexcept;
+    };
+} // namespace qz::gfx
\ No newline at end of file
@@ -1,6 +1,9 @@
 #include <qz/gfx/context.hpp>
 #include <qz/gfx/image.hpp>
 
+#include <algorithm>
+#include <cmath>
+
 namespace qz::gfx {
     qz_nodiscard VkImageAspectFlags aspect_from_format(const VkFormat format) noexcept {
         switch (format) {
@@ -18,9 +21,77 @@ namespace qz::gfx {
         }
     }
 
-    qz_nodiscard Image Image::create(const Context& context, const Image::CreateInfo& info) noexcept {
-        Image image{};
+    qz_nodiscard bool is_block_compressed(const VkFormat format) noexcept {
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    qz_nodiscard std::size_t level_size(const VkFormat format, const std::uint32_t width, const std::uint32_t height) noexcept {
+        const auto blocks = static_cast<std::size_t>((width + 3) / 4) * ((height + 3) / 4);
+        switch (format) {
+            case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+            case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+            case VK_FORMAT_BC4_UNORM_BLOCK:
+                return blocks * 8;
+            case VK_FORMAT_BC3_UNORM_BLOCK:
+            case VK_FORMAT_BC3_SRGB_BLOCK:
+            case VK_FORMAT_BC5_UNORM_BLOCK:
+            case VK_FORMAT_BC5_SNORM_BLOCK:
+            case VK_FORMAT_BC7_UNORM_BLOCK:
+            case VK_FORMAT_BC7_SRGB_BLOCK:
+                return blocks * 16;
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return static_cast<std::size_t>(width) * height * 4;
+            default:
+                qz_force_assert("Unsupported texture format");
+        }
+    }
+
+    qz_nodiscard std::uint32_t max_mips(const std::uint32_t width, const std::uint32_t height) noexcept {
+        return static_cast<std::uint32_t>(std::floor(std::log2(std::max(width, height)))) + 1;
+    }
+
+    qz_nodiscard static VkImageView create_view(const Context& context, VkImage image, const VkFormat format, const VkImageAspectFlags aspect, const std::uint32_t mips) noexcept {
+        VkImageView view;
+        VkImageViewCreateInfo view_create_info{};
+        view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        view_create_info.flags = {};
+        view_create_info.image = image;
+        view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        view_create_info.format = format;
+        view_create_info.components = {
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY,
+            VK_COMPONENT_SWIZZLE_IDENTITY
+        };
+        view_create_info.subresourceRange.aspectMask = aspect;
+        view_create_info.subresourceRange.baseMipLevel = 0;
+        view_create_info.subresourceRange.levelCount = mips;
+        view_create_info.subresourceRange.baseArrayLayer = 0;
+        view_create_info.subresourceRange.layerCount = 1;
+        qz_vulkan_check(vkCreateImageView(context.device, &view_create_info, nullptr, &view));
+        return view;
+    }
 
+    qz_nodiscard static VkImageCreateInfo make_image_info(const Image::CreateInfo& info) noexcept {
         VkImageCreateInfo image_create_info{};
         image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
         image_create_info.flags = {};
@@ -36,6 +107,13 @@ namespace qz::gfx {
         image_create_info.queueFamilyIndexCount = 0;
         image_create_info.pQueueFamilyIndices = nullptr;
         image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        return image_create_info;
+    }
+
+    qz_nodiscard Image Image::create(const Context& context, const Image::CreateInfo& info) noexcept {
+        Image image{};
+
+        const auto image_create_info = make_image_info(info);
 
         VmaAllocationCreateInfo allocation_create_info{};
         allocation_create_info.flags = {};
@@ -55,25 +133,21 @@ namespace qz::gfx {
             nullptr));
 
         image.aspect = aspect_from_format(info.format);
-        VkImageViewCreateInfo view_create_info{};
-        view_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        view_create_info.flags = {};
-        view_create_info.image = image.handle;
-        view_create_info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        view_create_info.format = info.format;
-        view_create_info.components = {
-            VK_COMPONENT_SWIZZLE_IDENTITY,
-            VK_COMPONENT_SWIZZLE_IDENTITY,
-            VK_COMPONENT_SWIZZLE_IDENTITY,
-            VK_COMPONENT_SWIZZLE_IDENTITY
-        };
-        view_create_info.subresourceRange.aspectMask = image.aspect;
-        view_create_info.subresourceRange.baseMipLevel = 0;
-        view_create_info.subresourceRange.levelCount = info.mips;
-        view_create_info.subresourceRange.baseArrayLayer = 0;
-        view_create_info.subresourceRange.layerCount = 1;
-        qz_vulkan_check(vkCreateImageView(context.device, &view_create_info, nullptr, &image.view));
+        image.view = create_view(context, image.handle, info.format, image.aspect, info.mips);
+        image.format = info.format;
+        image.height = info.height;
+        image.width = info.width;
+        image.mips = info.mips;
+
+        return image;
+    }
+
+    qz_nodiscard Image Image::create_unbound(const Context& context, const Image::CreateInfo& info) noexcept {
+        Image image{};
+        const auto image_create_info = make_image_info(info);
+        qz_vulkan_check(vkCreateImage(context.device, &image_create_info, nullptr, &image.handle));
 
+        image.aspect = aspect_from_format(info.format);
         image.format = info.format;
         image.height = info.height;
         image.width = info.width;
@@ -82,6 +156,12 @@ namespace qz::gfx {
         return image;
     }
 
+    void Image::bind(const Context& context, Image& image, VmaAllocation allocation) noexcept {
+        // The allocation isn't owned by the image, destroy() leaves it alone.
+        qz_vulkan_check(vmaBindImageMemory(context.allocator, allocation, image.handle));
+        image.view = create_view(context, image.handle, image.format, image.aspect, image.mips);
+    }
+
     void Image::destroy(const Context& context, Image& image) noexcept {
         vkDestroyImageView(context.device, image.view, nullptr);
         vmaDestroyImage(context.allocator, image.handle, image.allocation);
@@ -28,8 +28,16 @@ namespace qz::gfx {
         std::uint32_t height;
 
         qz_nodiscard static Image create(const Context&, const Image::CreateInfo&) noexcept;
+        // Creates the image without memory, bind() places it in an allocation it may share with other images.
+        qz_nodiscard static Image create_unbound(const Context&, const Image::CreateInfo&) noexcept;
+        static void bind(const Context&, Image&, VmaAllocation) noexcept;
         static void destroy(const Context&, Image&) noexcept;
     };
 
     qz_nodiscard VkImageAspectFlags aspect_from_format(VkFormat) noexcept;
+    qz_nodiscard bool is_block_compressed(VkFormat) noexcept;
+    // Bytes of one tightly packed level, block compressed levels are rounded up to whole 4x4 blocks.
+    qz_nodiscard std::size_t level_size(VkFormat, std::uint32_t, std::uint32_t) noexcept;
+    // Length of the full mip chain down to 1x1.
+    qz_nodiscard std::uint32_t max_mips(std::uint32_t, std::uint32_t) noexcept;
 } // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,53 @@
+#include <qz/gfx/command_buffer.hpp>
+#include <qz/gfx/instance_ring.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <qz/meta/constants.hpp>
+
+#include <cstring>
+
+namespace qz::gfx {
+    qz_nodiscard InstanceRing InstanceRing::create(const Context& context, CreateInfo&& info) noexcept {
+        InstanceRing ring{};
+        ring.buffer = Buffer::create(context, {
+            .flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            .usage = VMA_MEMORY_USAGE_CPU_TO_GPU,
+            .capacity = info.capacity * meta::in_flight
+        });
+        ring.capacity = info.capacity;
+        return ring;
+    }
+
+    void InstanceRing::destroy(const Context& context, InstanceRing& ring) noexcept {
+        Buffer::destroy(context, ring.buffer);
+        ring = {};
+    }
+
+    void InstanceRing::begin_frame(const std::uint32_t index) noexcept {
+        frame = index;
+        head = 0;
+    }
+
+    qz_nodiscard std::uint32_t InstanceRing::write(const void* data, const std::uint32_t count, const std::uint32_t stride) noexcept {
+        // Rounded up to the stride so the offset is a whole number of instances.
+        const auto offset = (head + stride - 1) / stride * stride;
+        const auto size = static_cast<std::size_t>(count) * stride;
+        // Writing on would overrun into the next frame's region, which may still be in flight.
+        if (offset > capacity || size > capacity - offset) {
+            qz_force_assert("Instance ring region is full");
+        }
+        std::memcpy(static_cast<char*>(buffer.mapped) + frame * capacity + offset, data, size);
+        head = offset + size;
+        return offset / stride;
+    }
+
+    void InstanceRing::flush(const Context& context) const noexcept {
+        if (head != 0) {
+            vmaFlushAllocation(context.allocator, buffer.allocation, frame * capacity, head);
+        }
+    }
+
+    void InstanceRing::bind(CommandBuffer& command_buffer) const noexcept {
+        command_buffer.bind_vertex_buffer(buffer, 1, frame * capacity);
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/gfx/buffer.hpp>
+
+#include <cstdint>
+
+namespace qz::gfx {
+    // Persistently mapped per-instance vertex stream rewritten every frame. Each frame in flight owns a region
+    // of the buffer, which it can reuse as soon as the frame's fence has signaled.
+    struct InstanceRing {
+        struct CreateInfo {
+            // Bytes available to each frame in flight.
+            std::size_t capacity;
+        };
+
+        Buffer buffer;
+        std::size_t capacity;
+        std::size_t head;
+        std::uint32_t frame;
+
+        qz_nodiscard static InstanceRing create(const Context&, CreateInfo&&) noexcept;
+        static void destroy(const Context&, InstanceRing&) noexcept;
+
+        // Starts writing the given frame in flight's region from the beginning.
+        void begin_frame(std::uint32_t) noexcept;
+        // Copies the instances and returns the first one's index relative to the region, usable as first instance
+        // while the region is bound with the same stride. Writes are only visible to the GPU after flush().
+        qz_nodiscard std::uint32_t write(const void*, std::uint32_t, std::uint32_t) noexcept;
+        void flush(const Context&) const noexcept;
+        // Binds the current frame's region to the per-instance vertex binding.
+        void bind(CommandBuffer&) const noexcept;
+    };
+} // namespace qz::gfx
\ No newline at end of file
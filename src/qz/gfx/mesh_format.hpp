@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+namespace qz::gfx {
+    // "QZM\0" read as a little-endian word.
+    constexpr auto mesh_file_magic = static_cast<std::uint32_t>(0x004d5a51);
+    constexpr auto mesh_file_version = static_cast<std::uint32_t>(5);
+    // Every section starts at a multiple of this, relative to the beginning of the file.
+    constexpr auto mesh_file_alignment = static_cast<std::uint64_t>(16);
+    constexpr auto mesh_file_max_attributes = static_cast<std::uint32_t>(8);
+    constexpr auto max_mesh_lods = static_cast<std::uint32_t>(8);
+
+    // Range of the index section drawn for a level of detail, all levels share the vertex section.
+    struct MeshLod {
+        std::uint32_t first_index;
+        std::uint32_t index_count;
+        // Object space distance the level deviates from the full detail mesh by.
+        float error;
+    };
+
+    // Object space bounds of every vertex, the sphere is centered on the box.
+    struct MeshBounds {
+        float min[3];
+        float max[3];
+        float center[3];
+        float radius;
+    };
+
+    // Header of a .qzm file, followed by the vertex and index sections. Values are little-endian and sections
+    // are stored exactly as the GPU consumes them, so a loader can copy them into staging memory as-is.
+    struct MeshFileHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t attribute_count;
+        // VertexAttribute of each attribute, vertices are stored already packed.
+        std::uint32_t attributes[mesh_file_max_attributes];
+        // Size in bytes of a single index.
+        std::uint32_t index_size;
+        std::uint32_t vertex_count;
+        // Indices of every level of detail, stored one after the other.
+        std::uint32_t index_count;
+        std::uint32_t lod_count;
+        std::uint32_t reserved;
+        std::uint64_t vertex_offset;
+        std::uint64_t index_offset;
+        MeshLod lods[max_mesh_lods];
+        MeshBounds bounds;
+    };
+    static_assert(sizeof(MeshFileHeader) == 216);
+} // namespace qz::gfx
\ No newline at end of file
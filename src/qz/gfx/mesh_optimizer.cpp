@@ -0,0 +1,347 @@
+#include <qz/gfx/mesh_optimizer.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <array>
+#include <cmath>
+
+namespace qz::gfx {
+    // Simulates a FIFO cache with timestamps: a vertex is resident if it was loaded less than cache_size misses ago.
+    class CacheSimulator {
+        std::vector<std::uint32_t> _loaded;
+        std::uint32_t _size;
+        std::uint32_t _time;
+    public:
+        CacheSimulator(const std::size_t vertex_count, const std::uint32_t size) noexcept
+            : _loaded(vertex_count, 0), _size(size), _time(size + 1) {}
+
+        qz_nodiscard bool access(const std::uint32_t vertex) noexcept {
+            if (_time - _loaded[vertex] > _size) {
+                _loaded[vertex] = _time++;
+                return true;
+            }
+            return false;
+        }
+
+        void flush() noexcept {
+            _time += _size + 1;
+        }
+    };
+
+    qz_nodiscard VertexCacheStatistics analyze_vertex_cache(const std::span<const std::uint32_t> indices, const std::size_t vertex_count, const std::uint32_t cache_size) noexcept {
+        if (indices.empty()) {
+            return {};
+        }
+        CacheSimulator cache(vertex_count, cache_size);
+        std::vector<bool> referenced(vertex_count, false);
+        std::size_t misses = 0;
+        std::size_t unique = 0;
+        for (const auto each : indices) {
+            misses += cache.access(each);
+            if (!referenced[each]) {
+                referenced[each] = true;
+                ++unique;
+            }
+        }
+        return {
+            static_cast<float>(misses) / static_cast<float>(indices.size() / 3),
+            static_cast<float>(misses) / static_cast<float>(unique)
+        };
+    }
+
+    std::size_t deduplicate_vertices(std::vector<float>& vertices, const std::uint32_t components, const std::span<std::uint32_t> indices) noexcept {
+        const auto vertex_count = vertices.size() / components;
+        const auto vertex_size = components * sizeof(float);
+        const auto hash = [&](const std::size_t vertex) noexcept {
+            const auto bytes = reinterpret_cast<const std::uint8_t*>(vertices.data() + vertex * components);
+            auto result = static_cast<std::uint64_t>(14695981039346656037ull);
+            for (std::size_t i = 0; i < vertex_size; ++i) {
+                result = (result ^ bytes[i]) * 1099511628211ull;
+            }
+            return result;
+        };
+
+        std::unordered_multimap<std::uint64_t, std::uint32_t> unique;
+        std::vector<std::uint32_t> remap(vertex_count);
+        std::uint32_t count = 0;
+        unique.reserve(vertex_count);
+        for (std::size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            const auto key = hash(vertex);
+            const auto [first, last] = unique.equal_range(key);
+            const auto match = std::find_if(first, last, [&](const auto& each) noexcept {
+                return std::memcmp(vertices.data() + each.second * components, vertices.data() + vertex * components, vertex_size) == 0;
+            });
+            if (match != last) {
+                remap[vertex] = match->second;
+                continue;
+            }
+            // Compacts in place, the destination is never past the vertex being read.
+            std::memmove(vertices.data() + count * components, vertices.data() + vertex * components, vertex_size);
+            unique.emplace(key, count);
+            remap[vertex] = count++;
+        }
+        vertices.resize(count * components);
+        for (auto& each : indices) {
+            each = remap[each];
+        }
+        return count;
+    }
+
+    void optimize_vertex_cache(const std::span<std::uint32_t> indices, const std::size_t vertex_count, std::vector<std::uint32_t>& clusters, const std::uint32_t cache_size) noexcept {
+        const auto triangle_count = indices.size() / 3;
+        clusters.clear();
+        if (triangle_count == 0) {
+            return;
+        }
+
+        // Vertex to triangle adjacency, live counts are the number of triangles left to emit per vertex.
+        std::vector<std::uint32_t> live(vertex_count, 0);
+        for (const auto each : indices) {
+            ++live[each];
+        }
+        std::vector<std::uint32_t> offsets(vertex_count + 1, 0);
+        std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+        std::vector<std::uint32_t> adjacency(indices.size());
+        {
+            auto fill = offsets;
+            for (std::size_t i = 0; i < indices.size(); ++i) {
+                adjacency[fill[indices[i]]++] = i / 3;
+            }
+        }
+
+        std::vector<std::uint32_t> cache_time(vertex_count, 0);
+        std::vector<bool> emitted(triangle_count, false);
+        std::vector<std::uint32_t> dead_ends;
+        std::vector<std::uint32_t> candidates;
+        std::vector<std::uint32_t> output;
+        output.reserve(indices.size());
+        std::uint32_t time = cache_size + 1;
+        std::size_t cursor = 0;
+
+        const auto skip_dead_end = [&]() noexcept -> std::int64_t {
+            // Recently touched vertices first, then a linear scan for anything still live.
+            while (!dead_ends.empty()) {
+                const auto vertex = dead_ends.back();
+                dead_ends.pop_back();
+                if (live[vertex] > 0) {
+                    return vertex;
+                }
+            }
+            for (; cursor < vertex_count; ++cursor) {
+                if (live[cursor] > 0) {
+                    clusters.emplace_back(output.size() / 3);
+                    return cursor;
+                }
+            }
+            return -1;
+        };
+
+        std::int64_t fanning = skip_dead_end();
+        while (fanning >= 0) {
+            candidates.clear();
+            for (auto i = offsets[fanning]; i < offsets[fanning + 1]; ++i) {
+                const auto triangle = adjacency[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+                for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                    const auto vertex = indices[triangle * 3 + corner];
+                    output.emplace_back(vertex);
+                    dead_ends.emplace_back(vertex);
+                    candidates.emplace_back(vertex);
+                    --live[vertex];
+                    if (time - cache_time[vertex] > cache_size) {
+                        cache_time[vertex] = time++;
+                    }
+                }
+                emitted[triangle] = true;
+            }
+
+            // Prefer the candidate that stays in the cache longest while its remaining triangles are emitted.
+            std::int64_t next = -1;
+            std::int64_t best = -1;
+            for (const auto vertex : candidates) {
+                if (live[vertex] == 0) {
+                    continue;
+                }
+                std::int64_t priority = 0;
+                if (time - cache_time[vertex] + 2 * live[vertex] <= cache_size) {
+                    priority = time - cache_time[vertex];
+                }
+                if (priority > best) {
+                    best = priority;
+                    next = vertex;
+                }
+            }
+            fanning = next >= 0 ? next : skip_dead_end();
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    void optimize_overdraw(const std::span<std::uint32_t> indices,
+                           const std::span<const float> vertices,
+                           const std::uint32_t components,
+                           const std::span<const std::uint32_t> hard_clusters,
+                           const float threshold) noexcept {
+        const auto triangle_count = indices.size() / 3;
+        if (triangle_count == 0 || components < 3) {
+            return;
+        }
+        const auto vertex_count = vertices.size() / components;
+        const auto limit = analyze_vertex_cache(indices, vertex_count).acmr * threshold;
+
+        // Soft boundaries: a cluster ends as soon as its own cache efficiency, starting from a cold cache,
+        // is good enough that moving it around costs at most the threshold.
+        std::vector<std::uint32_t> clusters;
+        {
+            CacheSimulator cache(vertex_count, vertex_cache_size);
+            std::size_t next_hard = 0;
+            std::size_t misses = 0;
+            std::size_t start = 0;
+            for (std::size_t triangle = 0; triangle < triangle_count; ++triangle) {
+                const auto is_hard = next_hard < hard_clusters.size() && hard_clusters[next_hard] == triangle;
+                next_hard += is_hard;
+                const auto is_soft = triangle > start && static_cast<float>(misses) / static_cast<float>(triangle - start) <= limit;
+                if (triangle == 0 || is_hard || is_soft) {
+                    clusters.emplace_back(triangle);
+                    cache.flush();
+                    start = triangle;
+                    misses = 0;
+                }
+                for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                    misses += cache.access(indices[triangle * 3 + corner]);
+                }
+            }
+        }
+
+        const auto position = [&](const std::uint32_t vertex) noexcept {
+            const auto* data = vertices.data() + vertex * components;
+            return std::array<float, 3>{ data[0], data[1], data[2] };
+        };
+
+        // Area weighted centroid and normal of every cluster.
+        struct Cluster {
+            std::uint32_t first;
+            std::uint32_t last;
+            std::array<float, 3> centroid;
+            std::array<float, 3> normal;
+            float sort_key;
+        };
+        std::vector<Cluster> sorted(clusters.size());
+        std::array<float, 3> mesh_centroid{};
+        float mesh_area = 0;
+        for (std::size_t i = 0; i < clusters.size(); ++i) {
+            auto& cluster = sorted[i];
+            cluster.first = clusters[i];
+            cluster.last = i + 1 < clusters.size() ? clusters[i + 1] : triangle_count;
+            cluster.centroid = {};
+            cluster.normal = {};
+            float area = 0;
+            for (auto triangle = cluster.first; triangle < cluster.last; ++triangle) {
+                const auto a = position(indices[triangle * 3 + 0]);
+                const auto b = position(indices[triangle * 3 + 1]);
+                const auto c = position(indices[triangle * 3 + 2]);
+                const std::array<float, 3> ab = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                const std::array<float, 3> ac = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+                const std::array<float, 3> normal = {
+                    ab[1] * ac[2] - ab[2] * ac[1],
+                    ab[2] * ac[0] - ab[0] * ac[2],
+                    ab[0] * ac[1] - ab[1] * ac[0]
+                };
+                const auto weight = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+                for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                    cluster.centroid[axis] += (a[axis] + b[axis] + c[axis]) / 3.0f * weight;
+                    cluster.normal[axis] += normal[axis];
+                }
+                area += weight;
+            }
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                mesh_centroid[axis] += cluster.centroid[axis];
+                cluster.centroid[axis] /= area > 0 ? area : 1.0f;
+            }
+            mesh_area += area;
+        }
+        for (auto& each : mesh_centroid) {
+            each /= mesh_area > 0 ? mesh_area : 1.0f;
+        }
+        for (auto& cluster : sorted) {
+            cluster.sort_key = 0;
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                cluster.sort_key += (cluster.centroid[axis] - mesh_centroid[axis]) * cluster.normal[axis];
+            }
+        }
+
+        // Clusters facing away from the center occlude the others and go first.
+        std::stable_sort(sorted.begin(), sorted.end(), [](const auto& lhs, const auto& rhs) noexcept {
+            return lhs.sort_key > rhs.sort_key;
+        });
+        std::vector<std::uint32_t> output;
+        output.reserve(indices.size());
+        for (const auto& cluster : sorted) {
+            output.insert(output.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+        }
+        std::copy(output.begin(), output.end(), indices.begin());
+    }
+
+    std::size_t optimize_vertex_fetch(std::vector<float>& vertices, const std::uint32_t components, const std::span<std::uint32_t> indices) noexcept {
+        constexpr auto unused = static_cast<std::uint32_t>(-1);
+        std::vector<std::uint32_t> remap(vertices.size() / components, unused);
+        std::vector<float> output;
+        output.reserve(vertices.size());
+        std::uint32_t count = 0;
+        for (auto& each : indices) {
+            if (remap[each] == unused) {
+                remap[each] = count++;
+                const auto source = vertices.begin() + each * components;
+                output.insert(output.end(), source, source + components);
+            }
+            each = remap[each];
+        }
+        vertices = std::move(output);
+        return count;
+    }
+
+    qz_nodiscard MeshBounds compute_bounds(const std::span<const float> vertices, const std::uint32_t components) noexcept {
+        MeshBounds bounds{};
+        if (vertices.empty()) {
+            return bounds;
+        }
+        std::copy(vertices.begin(), vertices.begin() + 3, bounds.min);
+        std::copy(vertices.begin(), vertices.begin() + 3, bounds.max);
+        for (std::size_t i = 0; i < vertices.size(); i += components) {
+            for (std::uint32_t axis = 0; axis < 3; ++axis) {
+                bounds.min[axis] = std::min(bounds.min[axis], vertices[i + axis]);
+                bounds.max[axis] = std::max(bounds.max[axis], vertices[i + axis]);
+            }
+        }
+        for (std::uint32_t axis = 0; axis < 3; ++axis) {
+            bounds.center[axis] = (bounds.min[axis] + bounds.max[axis]) * 0.5f;
+        }
+        // Tighter than the box's half diagonal for most meshes.
+        float radius = 0;
+        for (std::size_t i = 0; i < vertices.size(); i += components) {
+            const auto x = vertices[i + 0] - bounds.center[0];
+            const auto y = vertices[i + 1] - bounds.center[1];
+            const auto z = vertices[i + 2] - bounds.center[2];
+            radius = std::max(radius, x * x + y * y + z * z);
+        }
+        bounds.radius = std::sqrt(radius);
+        return bounds;
+    }
+
+    MeshOptimization optimize_mesh(std::vector<float>& vertices, const std::uint32_t components, std::vector<std::uint32_t>& indices) noexcept {
+        MeshOptimization result{};
+        result.before = analyze_vertex_cache(indices, vertices.size() / components);
+
+        const auto vertex_count = deduplicate_vertices(vertices, components, indices);
+        std::vector<std::uint32_t> clusters;
+        optimize_vertex_cache(indices, vertex_count, clusters);
+        optimize_overdraw(indices, vertices, components, clusters);
+        const auto referenced = optimize_vertex_fetch(vertices, components, indices);
+
+        result.after = analyze_vertex_cache(indices, referenced);
+        return result;
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace qz::gfx {
+    // Post-transform cache simulated by every optimization, matches common hardware FIFO sizes.
+    constexpr auto vertex_cache_size = static_cast<std::uint32_t>(16);
+
+    struct VertexCacheStatistics {
+        // Average cache misses per triangle, 0.5 is the practical optimum for a regular grid.
+        float acmr;
+        // Average transforms per referenced vertex, 1.0 is optimal.
+        float atvr;
+    };
+
+    struct MeshOptimization {
+        VertexCacheStatistics before;
+        VertexCacheStatistics after;
+    };
+
+    qz_nodiscard VertexCacheStatistics analyze_vertex_cache(std::span<const std::uint32_t>, std::size_t, std::uint32_t = vertex_cache_size) noexcept;
+
+    // Merges bitwise identical vertices and remaps the indices, returns the new vertex count.
+    std::size_t deduplicate_vertices(std::vector<float>&, std::uint32_t, std::span<std::uint32_t>) noexcept;
+
+    // Tipsify: reorders triangles for post-transform cache locality. Writes the first triangle of every
+    // cluster that starts at a non-local restart, these are the boundaries overdraw ordering may move.
+    void optimize_vertex_cache(std::span<std::uint32_t>, std::size_t, std::vector<std::uint32_t>&, std::uint32_t = vertex_cache_size) noexcept;
+
+    // Sorts clusters so outward facing ones are drawn first, positions are the first three floats of every vertex.
+    // Clusters are split further while the cache efficiency stays within the threshold of the input's.
+    void optimize_overdraw(std::span<std::uint32_t>, std::span<const float>, std::uint32_t, std::span<const std::uint32_t>, float = 1.05f) noexcept;
+
+    // Reorders vertices by first use and drops unreferenced ones, returns the new vertex count.
+    std::size_t optimize_vertex_fetch(std::vector<float>&, std::uint32_t, std::span<std::uint32_t>) noexcept;
+
+    // Positions are the first three floats of every vertex.
+    qz_nodiscard MeshBounds compute_bounds(std::span<const float>, std::uint32_t) noexcept;
+
+    // Runs every stage above in order on unpacked vertices with the given number of floats per vertex.
+    MeshOptimization optimize_mesh(std::vector<float>&, std::uint32_t, std::vector<std::uint32_t>&) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
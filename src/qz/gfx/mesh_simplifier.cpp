@@ -0,0 +1,263 @@
+#include <qz/gfx/mesh_simplifier.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <array>
+#include <cmath>
+
+namespace qz::gfx {
+    // Symmetric 4x4 matrix accumulating squared distances to planes, only the upper triangle is stored.
+    // Planes are weighted by the area of their triangle, the total weight turns the sum into a mean.
+    struct Quadric {
+        std::array<double, 10> m;
+        double weight;
+
+        void add_plane(const double a, const double b, const double c, const double d, const double w) noexcept {
+            m[0] += w * a * a; m[1] += w * a * b; m[2] += w * a * c; m[3] += w * a * d;
+            m[4] += w * b * b; m[5] += w * b * c; m[6] += w * b * d;
+            m[7] += w * c * c; m[8] += w * c * d;
+            m[9] += w * d * d;
+            weight += w;
+        }
+
+        qz_nodiscard double evaluate(const float* p) const noexcept {
+            const double x = p[0], y = p[1], z = p[2];
+            return m[0] * x * x + 2 * m[1] * x * y + 2 * m[2] * x * z + 2 * m[3] * x
+                 + m[4] * y * y + 2 * m[5] * y * z + 2 * m[6] * y
+                 + m[7] * z * z + 2 * m[8] * z
+                 + m[9];
+        }
+
+        Quadric& operator +=(const Quadric& other) noexcept {
+            for (std::size_t i = 0; i < m.size(); ++i) {
+                m[i] += other.m[i];
+            }
+            weight += other.weight;
+            return *this;
+        }
+    };
+
+    // Mean squared distance from the point to the accumulated planes.
+    qz_nodiscard static double collapse_cost(const Quadric& quadric, const float* p) noexcept {
+        return quadric.weight > 0 ? std::max(quadric.evaluate(p), 0.0) / quadric.weight : 0.0;
+    }
+
+    struct Collapse {
+        std::uint32_t from;
+        std::uint32_t to;
+        double cost;
+    };
+
+    qz_nodiscard static std::array<double, 3> triangle_normal(const float* a, const float* b, const float* c) noexcept {
+        const double ab[] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+        const double ac[] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+        return {
+            ab[1] * ac[2] - ab[2] * ac[1],
+            ab[2] * ac[0] - ab[0] * ac[2],
+            ab[0] * ac[1] - ab[1] * ac[0]
+        };
+    }
+
+    qz_nodiscard std::vector<std::uint32_t> simplify_mesh(const std::span<const float> vertices,
+                                                          const std::uint32_t components,
+                                                          const std::span<const std::uint32_t> source,
+                                                          const std::size_t target,
+                                                          float& error) noexcept {
+        const auto vertex_count = vertices.size() / components;
+        const auto position = [&](const std::uint32_t vertex) noexcept {
+            return vertices.data() + vertex * components;
+        };
+        std::vector<std::uint32_t> indices(source.begin(), source.end());
+        error = 0;
+
+        // Vertices sharing a position with another vertex sit on an attribute seam, moving one
+        // of them would tear the surface open.
+        std::vector<bool> locked(vertex_count, false);
+        {
+            std::unordered_map<std::uint64_t, std::uint32_t> positions;
+            std::vector<std::uint32_t> canonical(vertex_count);
+            for (std::uint32_t vertex = 0; vertex < vertex_count; ++vertex) {
+                std::uint32_t bits[3];
+                std::memcpy(bits, position(vertex), sizeof bits);
+                const auto key = (static_cast<std::uint64_t>(bits[0]) * 73856093u) ^ (static_cast<std::uint64_t>(bits[1]) * 19349663u) ^ (static_cast<std::uint64_t>(bits[2]) * 83492791u);
+                const auto [it, inserted] = positions.try_emplace(key, vertex);
+                canonical[vertex] = it->second;
+                // Hash collisions only lock more vertices than needed.
+                if (!inserted) {
+                    locked[vertex] = true;
+                    locked[it->second] = true;
+                }
+            }
+
+            // Border edges have no opposite half edge.
+            std::unordered_map<std::uint64_t, std::uint32_t> edges;
+            const auto edge_key = [&](const std::uint32_t a, const std::uint32_t b) noexcept {
+                return (static_cast<std::uint64_t>(canonical[a]) << 32) | canonical[b];
+            };
+            for (std::size_t i = 0; i < indices.size(); i += 3) {
+                for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                    ++edges[edge_key(indices[i + corner], indices[i + (corner + 1) % 3])];
+                }
+            }
+            for (std::size_t i = 0; i < indices.size(); i += 3) {
+                for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                    const auto a = indices[i + corner];
+                    const auto b = indices[i + (corner + 1) % 3];
+                    if (!edges.contains(edge_key(b, a))) {
+                        locked[a] = true;
+                        locked[b] = true;
+                    }
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertex_count, Quadric{});
+        for (std::size_t i = 0; i < indices.size(); i += 3) {
+            const auto* a = position(indices[i + 0]);
+            auto normal = triangle_normal(a, position(indices[i + 1]), position(indices[i + 2]));
+            const auto length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+            if (length == 0) {
+                continue;
+            }
+            for (auto& each : normal) {
+                each /= length;
+            }
+            const auto d = -(normal[0] * a[0] + normal[1] * a[1] + normal[2] * a[2]);
+            for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                quadrics[indices[i + corner]].add_plane(normal[0], normal[1], normal[2], d, length * 0.5);
+            }
+        }
+
+        std::vector<std::uint32_t> remap(vertex_count);
+        std::vector<bool> touched(vertex_count);
+        std::vector<std::uint32_t> offsets(vertex_count + 1);
+        std::vector<std::uint32_t> adjacency;
+        std::vector<Collapse> collapses;
+        while (indices.size() > target) {
+            // Vertex to triangle adjacency of the current pass.
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (const auto each : indices) {
+                ++offsets[each + 1];
+            }
+            for (std::size_t i = 1; i < offsets.size(); ++i) {
+                offsets[i] += offsets[i - 1];
+            }
+            adjacency.resize(indices.size());
+            {
+                auto fill = offsets;
+                for (std::size_t i = 0; i < indices.size(); ++i) {
+                    adjacency[fill[indices[i]]++] = i / 3;
+                }
+            }
+
+            collapses.clear();
+            for (std::size_t i = 0; i < indices.size(); i += 3) {
+                for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                    const auto a = indices[i + corner];
+                    const auto b = indices[i + (corner + 1) % 3];
+                    auto quadric = quadrics[a];
+                    quadric += quadrics[b];
+                    if (!locked[a]) {
+                        collapses.push_back({ a, b, collapse_cost(quadric, position(b)) });
+                    }
+                    if (!locked[b]) {
+                        collapses.push_back({ b, a, collapse_cost(quadric, position(a)) });
+                    }
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const auto& lhs, const auto& rhs) noexcept {
+                return lhs.cost < rhs.cost;
+            });
+
+            for (std::uint32_t i = 0; i < vertex_count; ++i) {
+                remap[i] = i;
+            }
+            std::fill(touched.begin(), touched.end(), false);
+            auto remaining = indices.size();
+            std::size_t applied = 0;
+            for (const auto& collapse : collapses) {
+                if (remaining <= target) {
+                    break;
+                }
+                if (touched[collapse.from] || touched[collapse.to]) {
+                    continue;
+                }
+
+                // Rejects collapses that would flip any triangle surviving around the moved vertex.
+                auto flips = false;
+                std::size_t removed = 0;
+                for (auto j = offsets[collapse.from]; j < offsets[collapse.from + 1] && !flips; ++j) {
+                    const auto* triangle = &indices[adjacency[j] * 3];
+                    if (triangle[0] == collapse.to || triangle[1] == collapse.to || triangle[2] == collapse.to) {
+                        ++removed;
+                        continue;
+                    }
+                    const float* corners[3];
+                    const float* moved[3];
+                    for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                        corners[corner] = position(triangle[corner]);
+                        moved[corner] = triangle[corner] == collapse.from ? position(collapse.to) : corners[corner];
+                    }
+                    const auto before = triangle_normal(corners[0], corners[1], corners[2]);
+                    const auto after = triangle_normal(moved[0], moved[1], moved[2]);
+                    flips = before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0;
+                }
+                if (flips) {
+                    continue;
+                }
+
+                // Every vertex around the collapse is frozen for the rest of the pass, keeping adjacency valid.
+                for (auto j = offsets[collapse.from]; j < offsets[collapse.from + 1]; ++j) {
+                    for (std::uint32_t corner = 0; corner < 3; ++corner) {
+                        touched[indices[adjacency[j] * 3 + corner]] = true;
+                    }
+                }
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                error = std::max(error, static_cast<float>(std::sqrt(collapse.cost)));
+                remaining -= removed * 3;
+                ++applied;
+            }
+            if (applied == 0) {
+                break;
+            }
+
+            std::size_t write = 0;
+            for (std::size_t i = 0; i < indices.size(); i += 3) {
+                const auto a = remap[indices[i + 0]];
+                const auto b = remap[indices[i + 1]];
+                const auto c = remap[indices[i + 2]];
+                if (a != b && b != c && a != c) {
+                    indices[write++] = a;
+                    indices[write++] = b;
+                    indices[write++] = c;
+                }
+            }
+            indices.resize(write);
+        }
+        return indices;
+    }
+
+    qz_nodiscard std::vector<MeshLod> generate_lods(const std::span<const float> vertices,
+                                                    const std::uint32_t components,
+                                                    std::vector<std::uint32_t>& indices,
+                                                    const std::uint32_t count) noexcept {
+        std::vector<MeshLod> lods;
+        lods.push_back({ 0, static_cast<std::uint32_t>(indices.size()), 0.0f });
+        const auto full = std::vector<std::uint32_t>(indices.begin(), indices.end());
+        for (std::uint32_t level = 1; level < std::min(count, max_mesh_lods); ++level) {
+            // Every level is simplified from full detail so errors stay absolute.
+            const auto target = (lods.back().index_count / 6) * 3;
+            float error;
+            const auto simplified = simplify_mesh(vertices, components, full, target, error);
+            // Less than 10% fewer triangles isn't worth another level.
+            if (simplified.empty() || simplified.size() * 10 > lods.back().index_count * 9) {
+                break;
+            }
+            lods.push_back({ static_cast<std::uint32_t>(indices.size()), static_cast<std::uint32_t>(simplified.size()), error });
+            indices.insert(indices.end(), simplified.begin(), simplified.end());
+        }
+        return lods;
+    }
+} // namespace qz::gfx
\ No newline at end of file
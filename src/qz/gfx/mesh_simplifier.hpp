@@ -0,0 +1,21 @@
+#pragma once
+
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace qz::gfx {
+    // Quadric error metric edge collapse that only moves vertices onto their neighbours, so every level
+    // of detail indexes the original vertex buffer. Positions are the first three floats of every vertex,
+    // vertices on open borders or sharing their position with another vertex (attribute seams) are never moved.
+    // Returns the simplified indices, the error is written as an object space distance: the largest root mean
+    // square distance, weighted by triangle area, from a moved vertex to the planes it accumulated.
+    qz_nodiscard std::vector<std::uint32_t> simplify_mesh(std::span<const float>, std::uint32_t, std::span<const std::uint32_t>, std::size_t, float&) noexcept;
+
+    // Appends up to the given number of levels after the full detail indices, each halving the triangle count
+    // of the previous one. Stops early once simplification no longer makes meaningful progress.
+    qz_nodiscard std::vector<MeshLod> generate_lods(std::span<const float>, std::uint32_t, std::vector<std::uint32_t>&, std::uint32_t) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
@@ -1,24 +1,30 @@
+#include <qz/gfx/shader_store.hpp>
+#include <qz/gfx/reflection.hpp>
 #include <qz/gfx/pipeline.hpp>
 #include <qz/gfx/context.hpp>
+#include <qz/gfx/assets.hpp>
 
-#include <spirv.hpp>
-#include <spirv_glsl.hpp>
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+#include <qz/meta/types.hpp>
 
-#include <type_traits>
-#include <numeric>
-#include <fstream>
 #include <cstring>
 #include <string>
 
 namespace qz::gfx {
-    qz_nodiscard static std::vector<char> load_spirv_code(const char* path) noexcept {
-        std::ifstream file(path, std::ios::ate | std::ios::binary);
-        qz_assert(file.is_open(), "Failed to open file");
-
-        std::vector<char> spirv(file.tellg());
-        file.seekg(0, std::ios::beg);
-        file.read(spirv.data(), spirv.size());
-        return spirv;
+    qz_nodiscard static VkFormat attribute_format(const VertexAttribute attribute) noexcept {
+        switch (attribute) {
+            case VertexAttribute::vec1: return VK_FORMAT_R32_SFLOAT;
+            case VertexAttribute::vec2: return VK_FORMAT_R32G32_SFLOAT;
+            case VertexAttribute::vec3: return VK_FORMAT_R32G32B32_SFLOAT;
+            case VertexAttribute::vec4: return VK_FORMAT_R32G32B32A32_SFLOAT;
+            case VertexAttribute::half2: return VK_FORMAT_R16G16_SFLOAT;
+            case VertexAttribute::half4: return VK_FORMAT_R16G16B16A16_SFLOAT;
+            case VertexAttribute::snorm8x4: return VK_FORMAT_R8G8B8A8_SNORM;
+            case VertexAttribute::unorm8x4: return VK_FORMAT_R8G8B8A8_UNORM;
+            case VertexAttribute::a2b10g10r10: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+        }
+        return VK_FORMAT_UNDEFINED;
     }
 
     qz_nodiscard Pipeline Pipeline::create(const Context& context, CreateInfo&& info) noexcept {
@@ -31,46 +37,44 @@ namespace qz::gfx {
         pipeline_stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
         pipeline_stages[1].pName = "main";
 
+        const ShaderReflection* reflections[2];
         { // Vertex shader.
-            const auto binary = load_spirv_code(info.vertex);
+            const auto binary = shader_binary(info.vertex);
+            reflections[0] = &reflect_shader(binary, VK_SHADER_STAGE_VERTEX_BIT);
 
             // Fill VkShaderModuleCreateInfo struct, give it a pointer and size of the spirv code.
             VkShaderModuleCreateInfo module_create_info{};
             module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            module_create_info.codeSize = binary.size();
-            module_create_info.pCode = (const uint32_t*)binary.data();
+            module_create_info.codeSize = binary.size_bytes();
+            module_create_info.pCode = binary.data();
             qz_vulkan_check(vkCreateShaderModule(context.device, &module_create_info, nullptr, &pipeline_stages[0].module));
         }
 
         std::vector<VkPipelineColorBlendAttachmentState> attachment_outputs;
         { // Fragment shader.
-            const auto binary = load_spirv_code(info.fragment);
-            const auto compiler = spirv_cross::CompilerGLSL((const std::uint32_t*)binary.data(), binary.size() / sizeof(std::uint32_t));
-            const auto resources = compiler.get_shader_resources();
+            const auto binary = shader_binary(info.fragment);
+            reflections[1] = &reflect_shader(binary, VK_SHADER_STAGE_FRAGMENT_BIT);
 
             VkShaderModuleCreateInfo module_create_info{};
             module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-            module_create_info.codeSize = binary.size();
-            module_create_info.pCode = (const uint32_t*)binary.data();
+            module_create_info.codeSize = binary.size_bytes();
+            module_create_info.pCode = binary.data();
             qz_vulkan_check(vkCreateShaderModule(context.device, &module_create_info, nullptr, &pipeline_stages[1].module));
 
-            attachment_outputs.reserve(resources.stage_outputs.size());
-            for (const auto& output : resources.stage_outputs) {
-                attachment_outputs.push_back({
-                    .blendEnable = true,
-                    .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-                    .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-                    .colorBlendOp = VK_BLEND_OP_ADD,
-                    .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-                    .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-                    .alphaBlendOp = VK_BLEND_OP_ADD,
-                    .colorWriteMask =
-                        VK_COLOR_COMPONENT_R_BIT |
-                        VK_COLOR_COMPONENT_G_BIT |
-                        VK_COLOR_COMPONENT_B_BIT |
-                        VK_COLOR_COMPONENT_A_BIT
-                });
-            }
+            attachment_outputs.resize(reflections[1]->outputs, {
+                .blendEnable = true,
+                .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+                .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+                .colorBlendOp = VK_BLEND_OP_ADD,
+                .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+                .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+                .alphaBlendOp = VK_BLEND_OP_ADD,
+                .colorWriteMask =
+                    VK_COLOR_COMPONENT_R_BIT |
+                    VK_COLOR_COMPONENT_G_BIT |
+                    VK_COLOR_COMPONENT_B_BIT |
+                    VK_COLOR_COMPONENT_A_BIT
+            });
         }
 
         // VkPipelineDynamicStateCreateInfo, Used to enable some dynamic pipeline states (such as Viewport or Scissor).
@@ -78,39 +82,52 @@ namespace qz::gfx {
         pipeline_dynamic_states.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
         pipeline_dynamic_states.dynamicStateCount = info.states.size();
         pipeline_dynamic_states.pDynamicStates = info.states.data();
+        std::uint32_t dynamic_states = 0;
+        for (const auto each : info.states) {
+            // Extension states start at 1000000000, shifting by them would be undefined.
+            if (static_cast<std::uint32_t>(each) >= 32) {
+                qz_force_assert("Only core dynamic states are supported");
+            }
+            dynamic_states |= 1u << each;
+        }
 
-        VkVertexInputBindingDescription vertex_binding_description{};
-        vertex_binding_description.binding = 0;
-        vertex_binding_description.stride =
-            std::accumulate(info.attributes.begin(), info.attributes.end(), 0u, [](const auto value, const auto attribute) {
-                return value + static_cast<std::underlying_type_t<decltype(attribute)>>(attribute);
+        // Per-vertex attributes come from binding 0, per-instance ones from binding 1 and continue their locations.
+        std::vector<VkVertexInputBindingDescription> vertex_binding_descriptions{ {
+            .binding = 0,
+            .stride = vertex_stride(info.attributes),
+            .inputRate = VK_VERTEX_INPUT_RATE_VERTEX
+        } };
+        if (!info.instance_attributes.empty()) {
+            vertex_binding_descriptions.push_back({
+                .binding = 1,
+                .stride = vertex_stride(info.instance_attributes),
+                .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE
             });
-        vertex_binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        }
 
+        // Attributes are laid out by the caller, the shader's reflected inputs only validate them.
+        qz_assert(reflections[0]->inputs.size() == info.attributes.size() + info.instance_attributes.size(),
+                  "Vertex and instance attributes don't match the vertex shader's inputs");
         std::vector<VkVertexInputAttributeDescription> vertex_attribute_descriptions{};
-        for (std::uint32_t location = 0, offset = 0; const auto each : info.attributes) {
-            vertex_attribute_descriptions.push_back({
-                .location = location++,
-                .binding = 0,
-                .format = [each]() noexcept {
-                    switch (each) {
-                        case VertexAttribute::vec1: return VK_FORMAT_R32_SFLOAT;
-                        case VertexAttribute::vec2: return VK_FORMAT_R32G32_SFLOAT;
-                        case VertexAttribute::vec3: return VK_FORMAT_R32G32B32_SFLOAT;
-                        case VertexAttribute::vec4: return VK_FORMAT_R32G32B32A32_SFLOAT;
-                    }
-                    return VK_FORMAT_UNDEFINED;
-                }(),
-                .offset = offset
-            });
-            offset += static_cast<std::underlying_type_t<decltype(each)>>(each);
+        std::uint32_t location = 0;
+        for (std::uint32_t binding = 0; const auto* attributes : { &info.attributes, &info.instance_attributes }) {
+            for (std::uint32_t offset = 0; const auto each : *attributes) {
+                vertex_attribute_descriptions.push_back({
+                    .location = location++,
+                    .binding = binding,
+                    .format = attribute_format(each),
+                    .offset = offset
+                });
+                offset += attribute_size(each);
+            }
+            binding++;
         }
 
         // VkPipelineVertexInputStateCreateInfo, Used to specify input vertex format of a shader.
         VkPipelineVertexInputStateCreateInfo vertex_input_state{};
         vertex_input_state.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertex_input_state.vertexBindingDescriptionCount = 1;
-        vertex_input_state.pVertexBindingDescriptions = &vertex_binding_description;
+        vertex_input_state.vertexBindingDescriptionCount = vertex_binding_descriptions.size();
+        vertex_input_state.pVertexBindingDescriptions = vertex_binding_descriptions.data();
         vertex_input_state.vertexAttributeDescriptionCount = vertex_attribute_descriptions.size();
         vertex_input_state.pVertexAttributeDescriptions = vertex_attribute_descriptions.data();
 
@@ -180,17 +197,8 @@ namespace qz::gfx {
         color_blend_state.blendConstants[2] = 0.0f;
         color_blend_state.blendConstants[3] = 0.0f;
 
-        // VkPipelineLayoutCreateInfo, Description of our shader's resources layout (uniform buffers and whatnot).
-        VkPipelineLayoutCreateInfo layout_create_info{};
-        layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        layout_create_info.setLayoutCount = 0;
-        layout_create_info.pSetLayouts = nullptr;
-        layout_create_info.pushConstantRangeCount = 0;
-        layout_create_info.pPushConstantRanges = nullptr;
-
-        // Create pipeline layout
-        VkPipelineLayout layout;
-        qz_vulkan_check(vkCreatePipelineLayout(context.device, &layout_create_info, nullptr, &layout));
+        // Layouts are deduplicated across pipelines sharing the same descriptor sets and push constants.
+        const auto& layout = request_pipeline_layout(context, reflections);
 
         // Finally, VkGraphicsPipelineCreateInfo, Uses all the informations we gathered so far.
         VkGraphicsPipelineCreateInfo pipeline_create_info{};
@@ -205,7 +213,7 @@ namespace qz::gfx {
         pipeline_create_info.pDepthStencilState = &depth_stencil_state;
         pipeline_create_info.pColorBlendState = &color_blend_state;
         pipeline_create_info.pDynamicState = &pipeline_dynamic_states;
-        pipeline_create_info.layout = layout;
+        pipeline_create_info.layout = layout.handle;
         pipeline_create_info.renderPass = info.render_pass;
         pipeline_create_info.subpass = info.subpass;
         pipeline_create_info.basePipelineHandle = nullptr;
@@ -213,16 +221,117 @@ namespace qz::gfx {
 
         // Create pipeline.
         VkPipeline pipeline;
-        qz_vulkan_check(vkCreateGraphicsPipelines(context.device, nullptr, 1, &pipeline_create_info, nullptr, &pipeline));
+        qz_vulkan_check(vkCreateGraphicsPipelines(context.device, context.pipeline_cache.handle, 1, &pipeline_create_info, nullptr, &pipeline));
         vkDestroyShaderModule(context.device, pipeline_stages[0].module, nullptr);
         vkDestroyShaderModule(context.device, pipeline_stages[1].module, nullptr);
 
-        return { pipeline, layout };
+        return { pipeline, layout.handle, layout.sets, layout.push_constant_stages, VK_PIPELINE_BIND_POINT_GRAPHICS, dynamic_states };
+    }
+
+    qz_nodiscard Pipeline Pipeline::create_compute(const Context& context, ComputeCreateInfo&& info) noexcept {
+        const auto binary = shader_binary(info.compute);
+        const ShaderReflection* reflections[] = {
+            &reflect_shader(binary, VK_SHADER_STAGE_COMPUTE_BIT)
+        };
+
+        VkShaderModuleCreateInfo module_create_info{};
+        module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_create_info.codeSize = binary.size_bytes();
+        module_create_info.pCode = binary.data();
+
+        VkPipelineShaderStageCreateInfo pipeline_stage{};
+        pipeline_stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipeline_stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipeline_stage.pName = "main";
+        qz_vulkan_check(vkCreateShaderModule(context.device, &module_create_info, nullptr, &pipeline_stage.module));
+
+        const auto& layout = request_pipeline_layout(context, reflections);
+
+        VkComputePipelineCreateInfo pipeline_create_info{};
+        pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipeline_create_info.stage = pipeline_stage;
+        pipeline_create_info.layout = layout.handle;
+        pipeline_create_info.basePipelineHandle = nullptr;
+        pipeline_create_info.basePipelineIndex = -1;
+
+        VkPipeline pipeline;
+        qz_vulkan_check(vkCreateComputePipelines(context.device, context.pipeline_cache.handle, 1, &pipeline_create_info, nullptr, &pipeline));
+        vkDestroyShaderModule(context.device, pipeline_stage.module, nullptr);
+
+        return { pipeline, layout.handle, layout.sets, layout.push_constant_stages, VK_PIPELINE_BIND_POINT_COMPUTE, 0 };
     }
 
     void Pipeline::destroy(const Context& context, Pipeline& pipeline) noexcept {
+        // The layout is owned by the layout cache.
         vkDestroyPipeline(context.device, pipeline.handle, nullptr);
-        vkDestroyPipelineLayout(context.device, pipeline.layout, nullptr);
         pipeline = {};
     }
+
+    struct PipelineTaskData {
+        const Context* context;
+        meta::Handle<Pipeline> handle;
+        // Owned copies, the caller's paths may not outlive the request.
+        std::string vertex;
+        std::string fragment;
+        Pipeline::CreateInfo info;
+    };
+
+    qz_nodiscard meta::Handle<Pipeline> request_pipeline(const Context& context, Pipeline::CreateInfo&& info) noexcept {
+        const auto result = assets::emplace_empty<Pipeline>();
+
+        auto task_data = new PipelineTaskData{
+            &context,
+            result,
+            info.vertex,
+            info.fragment,
+            std::move(info)
+        };
+
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<PipelineTaskData*>(ptr);
+                data->info.vertex = data->vertex.c_str();
+                data->info.fragment = data->fragment.c_str();
+                // Pipelines compiled concurrently all go through the context's cache, which is internally synchronized.
+                assets::from_handle(data->handle) = Pipeline::create(*data->context, std::move(data->info));
+                assets::finalize(data->handle);
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = task_data
+        }, ftl::TaskPriority::Normal);
+        return result;
+    }
+
+    struct ComputePipelineTaskData {
+        const Context* context;
+        meta::Handle<Pipeline> handle;
+        std::string compute;
+    };
+
+    qz_nodiscard meta::Handle<Pipeline> request_pipeline(const Context& context, Pipeline::ComputeCreateInfo&& info) noexcept {
+        const auto result = assets::emplace_empty<Pipeline>();
+
+        auto task_data = new ComputePipelineTaskData{
+            &context,
+            result,
+            info.compute
+        };
+
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<ComputePipelineTaskData*>(ptr);
+                assets::from_handle(data->handle) = Pipeline::create_compute(*data->context, {
+                    .compute = data->compute.c_str()
+                });
+                assets::finalize(data->handle);
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = task_data
+        }, ftl::TaskPriority::Normal);
+        return result;
+    }
 } // namespace qz::gfx
@@ -3,32 +3,43 @@
 #include <qz/util/macros.hpp>
 #include <qz/util/fwd.hpp>
 
+#include <qz/gfx/vertex_format.hpp>
+
 #include <vulkan/vulkan.h>
 
 #include <cstdint>
 #include <vector>
 
 namespace qz::gfx {
-    enum class VertexAttribute : std::uint32_t {
-        vec1 = sizeof(float[1]),
-        vec2 = sizeof(float[2]),
-        vec3 = sizeof(float[3]),
-        vec4 = sizeof(float[4])
-    };
-
     struct Pipeline {
         struct CreateInfo {
             const char* vertex;
             const char* fragment;
             std::vector<VertexAttribute> attributes;
+            // Read once per instance from vertex binding 1, empty if the pipeline isn't instanced.
+            std::vector<VertexAttribute> instance_attributes;
             std::vector<VkDynamicState> states;
             VkRenderPass render_pass;
             std::uint32_t subpass;
         };
+
+        struct ComputeCreateInfo {
+            const char* compute;
+        };
         VkPipeline handle;
         VkPipelineLayout layout;
+        std::vector<VkDescriptorSetLayout> sets;
+        VkShaderStageFlags push_constant_stages;
+        VkPipelineBindPoint bind_point;
+        // One bit per core VkDynamicState left dynamic, state the pipeline bakes in is lost when it's bound.
+        std::uint32_t dynamic_states;
 
         qz_nodiscard static Pipeline create(const Context&, CreateInfo&&) noexcept;
+        qz_nodiscard static Pipeline create_compute(const Context&, ComputeCreateInfo&&) noexcept;
         static void destroy(const Context&, Pipeline&) noexcept;
     };
+
+    // Loads, reflects and compiles the pipeline on a worker, the handle is ready once it can be bound.
+    qz_nodiscard meta::Handle<Pipeline> request_pipeline(const Context&, Pipeline::CreateInfo&&) noexcept;
+    qz_nodiscard meta::Handle<Pipeline> request_pipeline(const Context&, Pipeline::ComputeCreateInfo&&) noexcept;
 } // namespace qz::gfx
\ No newline at end of file
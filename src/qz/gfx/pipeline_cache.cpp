@@ -0,0 +1,105 @@
+#include <qz/gfx/pipeline_cache.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <cstring>
+#include <vector>
+
+namespace qz::gfx {
+    constexpr auto cache_magic = 0x4350'5a51u; // "QZPC"
+    // Bumped whenever the file layout changes.
+    constexpr auto cache_version = 1u;
+
+    struct CacheHeader {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint32_t vendor;
+        std::uint32_t device;
+        std::uint32_t driver;
+        std::uint8_t uuid[VK_UUID_SIZE];
+        // Keeps the header free of padding so it can be compared with memcmp.
+        std::uint32_t reserved;
+        std::uint64_t size;
+    };
+    static_assert(sizeof(CacheHeader) == 48, "CacheHeader must not contain padding");
+
+    qz_nodiscard static CacheHeader make_header(const Context& context, const std::uint64_t size) noexcept {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(context.gpu, &properties);
+
+        CacheHeader header{};
+        header.magic = cache_magic;
+        header.version = cache_version;
+        header.vendor = properties.vendorID;
+        header.device = properties.deviceID;
+        header.driver = properties.driverVersion;
+        std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+        header.size = size;
+        return header;
+    }
+
+    // Returns the cached blob, or nothing if the file is missing, truncated or was written by another device or driver.
+    qz_nodiscard static std::vector<char> load_cache_data(const Context& context, const char* path) noexcept {
+        std::ifstream file(path, std::ios::ate | std::ios::binary);
+        if (!file.is_open()) {
+            return {};
+        }
+
+        const auto file_size = static_cast<std::size_t>(file.tellg());
+        if (file_size < sizeof(CacheHeader)) {
+            return {};
+        }
+
+        CacheHeader header;
+        file.seekg(0, std::ios::beg);
+        file.read(reinterpret_cast<char*>(&header), sizeof(CacheHeader));
+        const auto expected = make_header(context, file_size - sizeof(CacheHeader));
+        if (std::memcmp(&header, &expected, sizeof(CacheHeader)) != 0) {
+            return {};
+        }
+
+        std::vector<char> data(header.size);
+        file.read(data.data(), data.size());
+        if (!file) {
+            return {};
+        }
+        return data;
+    }
+
+    qz_nodiscard PipelineCache PipelineCache::create(const Context& context, const char* path) noexcept {
+        PipelineCache cache{};
+        cache.path = path;
+
+        const auto data = load_cache_data(context, path);
+        VkPipelineCacheCreateInfo pipeline_cache_create_info{};
+        pipeline_cache_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        pipeline_cache_create_info.flags = {};
+        pipeline_cache_create_info.initialDataSize = data.size();
+        pipeline_cache_create_info.pInitialData = data.empty() ? nullptr : data.data();
+        qz_vulkan_check(vkCreatePipelineCache(context.device, &pipeline_cache_create_info, nullptr, &cache.handle));
+
+        return cache;
+    }
+
+    void PipelineCache::destroy(const Context& context, PipelineCache& cache) noexcept {
+        std::size_t size;
+        qz_vulkan_check(vkGetPipelineCacheData(context.device, cache.handle, &size, nullptr));
+        std::vector<char> data(size);
+        qz_vulkan_check(vkGetPipelineCacheData(context.device, cache.handle, &size, data.data()));
+
+        // Written next to the old cache and renamed over it, a crash halfway never leaves a corrupted file behind.
+        const auto temporary = cache.path + ".tmp";
+        {
+            const auto header = make_header(context, size);
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+            file.write(data.data(), size);
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, cache.path, error);
+
+        vkDestroyPipelineCache(context.device, cache.handle, nullptr);
+        cache = {};
+    }
+} // namespace qz::gfx
\ No newline at end of file
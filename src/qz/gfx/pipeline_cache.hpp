@@ -0,0 +1,20 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+namespace qz::gfx {
+    // VkPipelineCache backed by a file, the blob is only reused on the exact device and driver that wrote it.
+    struct PipelineCache {
+        VkPipelineCache handle;
+        std::string path;
+
+        qz_nodiscard static PipelineCache create(const Context&, const char*) noexcept;
+        // Writes the cache back to disk before destroying it.
+        static void destroy(const Context&, PipelineCache&) noexcept;
+    };
+} // namespace qz::gfx
\ No newline at end of file
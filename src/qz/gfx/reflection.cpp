@@ -0,0 +1,233 @@
+#include <qz/gfx/reflection.hpp>
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <spirv.hpp>
+#include <spirv_glsl.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+
+namespace qz::gfx {
+    // Reflections are looked up by workers compiling pipelines concurrently, entries are never erased
+    // before destroy_reflection() so references handed out stay valid.
+    static std::mutex reflection_mutex;
+    static std::unordered_map<std::uint64_t, ShaderReflection> reflections;
+    static std::unordered_map<std::uint64_t, VkDescriptorSetLayout> set_layouts;
+    static std::unordered_map<std::uint64_t, PipelineLayout> pipeline_layouts;
+
+    // FNV-1a, only used to identify binaries and layout descriptions.
+    qz_nodiscard static std::uint64_t hash_bytes(const void* data, const std::size_t size, std::uint64_t hash = 14695981039346656037ull) noexcept {
+        const auto bytes = static_cast<const std::uint8_t*>(data);
+        for (std::size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    template <typename T>
+    qz_nodiscard static std::uint64_t hash_value(const T& value, const std::uint64_t hash) noexcept {
+        return hash_bytes(&value, sizeof(T), hash);
+    }
+
+    qz_nodiscard static VkFormat input_format(const spirv_cross::SPIRType& type) noexcept {
+        constexpr VkFormat float_formats[] = {
+            VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT
+        };
+        constexpr VkFormat int_formats[] = {
+            VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT
+        };
+        constexpr VkFormat uint_formats[] = {
+            VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT
+        };
+        qz_assert(1 <= type.vecsize && type.vecsize <= 4, "Unsupported vertex input width");
+        switch (type.basetype) {
+            case spirv_cross::SPIRType::Float: return float_formats[type.vecsize - 1];
+            case spirv_cross::SPIRType::Int:   return int_formats[type.vecsize - 1];
+            case spirv_cross::SPIRType::UInt:  return uint_formats[type.vecsize - 1];
+            default: break;
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    qz_nodiscard const ShaderReflection& reflect_shader(const std::span<const std::uint32_t> code, const VkShaderStageFlagBits stage) noexcept {
+        const auto hash = hash_bytes(code.data(), code.size_bytes());
+        {
+            std::lock_guard<std::mutex> lock(reflection_mutex);
+            if (const auto it = reflections.find(hash); it != reflections.end()) {
+                return it->second;
+            }
+        }
+
+        // Reflection runs without the lock, two workers racing on the same binary produce the same result.
+        const auto compiler = spirv_cross::CompilerGLSL(code.data(), code.size());
+        const auto resources = compiler.get_shader_resources();
+
+        ShaderReflection reflection{};
+        reflection.hash = hash;
+        reflection.stage = stage;
+        const auto add_bindings = [&](const auto& list, const VkDescriptorType type) {
+            for (const auto& each : list) {
+                const auto& spirv_type = compiler.get_type(each.type_id);
+                reflection.bindings.push_back({
+                    .set = compiler.get_decoration(each.id, spv::DecorationDescriptorSet),
+                    .binding = compiler.get_decoration(each.id, spv::DecorationBinding),
+                    .type = type,
+                    .count = spirv_type.array.empty() ? 1 : spirv_type.array[0],
+                    .stages = static_cast<VkShaderStageFlags>(stage)
+                });
+            }
+        };
+        add_bindings(resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER);
+        add_bindings(resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+        add_bindings(resources.sampled_images, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER);
+        add_bindings(resources.separate_images, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE);
+        add_bindings(resources.separate_samplers, VK_DESCRIPTOR_TYPE_SAMPLER);
+        add_bindings(resources.storage_images, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
+        add_bindings(resources.subpass_inputs, VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT);
+
+        for (const auto& each : resources.push_constant_buffers) {
+            const auto size = compiler.get_declared_struct_size(compiler.get_type(each.base_type_id));
+            reflection.push_constants.push_back({
+                .stageFlags = static_cast<VkShaderStageFlags>(stage),
+                .offset = 0,
+                .size = static_cast<std::uint32_t>(size)
+            });
+        }
+
+        if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
+            for (const auto& each : resources.stage_inputs) {
+                reflection.inputs.push_back({
+                    .location = compiler.get_decoration(each.id, spv::DecorationLocation),
+                    .format = input_format(compiler.get_type(each.type_id))
+                });
+            }
+            std::sort(reflection.inputs.begin(), reflection.inputs.end(), [](const auto& lhs, const auto& rhs) {
+                return lhs.location < rhs.location;
+            });
+        }
+        reflection.outputs = resources.stage_outputs.size();
+
+        std::lock_guard<std::mutex> lock(reflection_mutex);
+        return reflections.try_emplace(hash, std::move(reflection)).first->second;
+    }
+
+    // Must be called with reflection_mutex held.
+    qz_nodiscard static VkDescriptorSetLayout request_set_layout(const Context& context, const std::vector<VkDescriptorSetLayoutBinding>& bindings) noexcept {
+        auto hash = hash_value(bindings.size(), 14695981039346656037ull);
+        for (const auto& each : bindings) {
+            hash = hash_value(each.binding, hash);
+            hash = hash_value(each.descriptorType, hash);
+            hash = hash_value(each.descriptorCount, hash);
+            hash = hash_value(each.stageFlags, hash);
+        }
+        if (const auto it = set_layouts.find(hash); it != set_layouts.end()) {
+            return it->second;
+        }
+
+        VkDescriptorSetLayout set_layout;
+        VkDescriptorSetLayoutCreateInfo set_layout_create_info{};
+        set_layout_create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        set_layout_create_info.flags = {};
+        set_layout_create_info.bindingCount = bindings.size();
+        set_layout_create_info.pBindings = bindings.data();
+        qz_vulkan_check(vkCreateDescriptorSetLayout(context.device, &set_layout_create_info, nullptr, &set_layout));
+        return set_layouts[hash] = set_layout;
+    }
+
+    qz_nodiscard const PipelineLayout& request_pipeline_layout(const Context& context, const std::span<const ShaderReflection* const> stages) noexcept {
+        // Bindings used by several stages are merged into one, visible to all of them.
+        std::vector<DescriptorBinding> bindings;
+        VkPushConstantRange push_constants{};
+        for (const auto* stage : stages) {
+            for (const auto& each : stage->bindings) {
+                const auto it = std::find_if(bindings.begin(), bindings.end(), [&each](const auto& binding) {
+                    return binding.set == each.set && binding.binding == each.binding;
+                });
+                if (it != bindings.end()) {
+                    qz_assert(it->type == each.type, "Descriptor type mismatch between stages");
+                    it->stages |= each.stages;
+                } else {
+                    bindings.emplace_back(each);
+                }
+            }
+            for (const auto& each : stage->push_constants) {
+                push_constants.stageFlags |= each.stageFlags;
+                push_constants.size = std::max(push_constants.size, each.size);
+            }
+        }
+        std::sort(bindings.begin(), bindings.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.set != rhs.set ? lhs.set < rhs.set : lhs.binding < rhs.binding;
+        });
+
+        std::lock_guard<std::mutex> lock(reflection_mutex);
+        // Every layout has the bindless set, so the table can be bound whether or not the shaders use it.
+        // Sets without bindings still need a layout when a higher set is used.
+        std::vector<VkDescriptorSetLayout> sets(std::max(bindless_set + 1, bindings.empty() ? 0 : bindings.back().set + 1));
+        for (std::uint32_t set = 0; set < sets.size(); ++set) {
+            // The bindless set always uses the shared table layout, shaders may declare any subset of it.
+            if (set == bindless_set) {
+                for (const auto& each : bindings) {
+                    if (each.set == set) {
+                        qz_assert(((each.binding == bindless_buffer_binding && each.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) ||
+                                   (each.binding == bindless_image_binding && each.type == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE) ||
+                                   (each.binding == bindless_sampler_binding && each.type == VK_DESCRIPTOR_TYPE_SAMPLER)),
+                                  "Binding does not match the bindless table");
+                    }
+                }
+                sets[set] = bindless_set_layout();
+                continue;
+            }
+            std::vector<VkDescriptorSetLayoutBinding> set_bindings;
+            for (const auto& each : bindings) {
+                if (each.set == set) {
+                    set_bindings.push_back({
+                        .binding = each.binding,
+                        .descriptorType = each.type,
+                        .descriptorCount = each.count,
+                        .stageFlags = each.stages,
+                        .pImmutableSamplers = nullptr
+                    });
+                }
+            }
+            sets[set] = request_set_layout(context, set_bindings);
+        }
+
+        auto hash = hash_value(sets.size(), 14695981039346656037ull);
+        for (const auto each : sets) {
+            hash = hash_value(each, hash);
+        }
+        hash = hash_value(push_constants.stageFlags, hash);
+        hash = hash_value(push_constants.size, hash);
+        if (const auto it = pipeline_layouts.find(hash); it != pipeline_layouts.end()) {
+            return it->second;
+        }
+
+        PipelineLayout layout{};
+        layout.sets = std::move(sets);
+        layout.push_constant_stages = push_constants.stageFlags;
+
+        VkPipelineLayoutCreateInfo layout_create_info{};
+        layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        layout_create_info.setLayoutCount = layout.sets.size();
+        layout_create_info.pSetLayouts = layout.sets.data();
+        layout_create_info.pushConstantRangeCount = push_constants.size != 0;
+        layout_create_info.pPushConstantRanges = &push_constants;
+        qz_vulkan_check(vkCreatePipelineLayout(context.device, &layout_create_info, nullptr, &layout.handle));
+        return pipeline_layouts[hash] = std::move(layout);
+    }
+
+    void destroy_reflection(const Context& context) noexcept {
+        std::lock_guard<std::mutex> lock(reflection_mutex);
+        for (const auto& [_, each] : pipeline_layouts) {
+            vkDestroyPipelineLayout(context.device, each.handle, nullptr);
+        }
+        for (const auto& [_, each] : set_layouts) {
+            vkDestroyDescriptorSetLayout(context.device, each, nullptr);
+        }
+        pipeline_layouts = {};
+        set_layouts = {};
+        reflections = {};
+    }
+} // namespace qz::gfx
\ No newline at end of file
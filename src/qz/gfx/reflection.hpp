@@ -0,0 +1,50 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace qz::gfx {
+    struct DescriptorBinding {
+        std::uint32_t set;
+        std::uint32_t binding;
+        VkDescriptorType type;
+        // Zero for runtime sized arrays.
+        std::uint32_t count;
+        VkShaderStageFlags stages;
+    };
+
+    struct VertexInput {
+        std::uint32_t location;
+        VkFormat format;
+    };
+
+    // Interface of a SPIR-V module, computed once per unique binary.
+    struct ShaderReflection {
+        std::uint64_t hash;
+        VkShaderStageFlagBits stage;
+        std::vector<DescriptorBinding> bindings;
+        std::vector<VkPushConstantRange> push_constants;
+        std::vector<VertexInput> inputs;
+        std::uint32_t outputs;
+    };
+
+    // Layout objects shared by every pipeline with an identical interface, owned by the layout cache.
+    struct PipelineLayout {
+        VkPipelineLayout handle;
+        std::vector<VkDescriptorSetLayout> sets;
+        VkShaderStageFlags push_constant_stages;
+    };
+
+    qz_nodiscard const ShaderReflection& reflect_shader(std::span<const std::uint32_t>, VkShaderStageFlagBits) noexcept;
+
+    // Merges the interfaces of every stage and returns the cached layout for them, creating it on first use.
+    qz_nodiscard const PipelineLayout& request_pipeline_layout(const Context&, std::span<const ShaderReflection* const>) noexcept;
+
+    void destroy_reflection(const Context&) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,470 @@
+#include <qz/gfx/command_buffer.hpp>
+#include <qz/gfx/render_graph.hpp>
+#include <qz/gfx/renderer.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <algorithm>
+#include <optional>
+
+namespace qz::gfx {
+    // How a pass touches a resource.
+    struct ResourceUsage {
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+    };
+
+    struct ResourceAccess {
+        std::size_t resource;
+        ResourceUsage usage;
+        VkImageUsageFlags flags;
+        bool attachment;
+    };
+
+    // A dependency only has to make writes available, reads never need to be flushed.
+    constexpr VkAccessFlags write_accesses =
+        VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_SHADER_WRITE_BIT |
+        VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    constexpr ResourceUsage transfer_usage = {
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_ACCESS_TRANSFER_READ_BIT,
+        VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL
+    };
+
+    constexpr auto unused = static_cast<std::size_t>(-1);
+
+    qz_nodiscard static bool is_depth(const VkFormat format) noexcept {
+        return aspect_from_format(format) & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT);
+    }
+
+    qz_nodiscard static ResourceAccess write_access(const std::size_t resource, const VkFormat format) noexcept {
+        const auto layout = deduce_reference_layout(aspect_from_format(format));
+        if (is_depth(format)) {
+            return { resource, {
+                VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+                layout
+            }, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true };
+        }
+        return { resource, {
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            layout
+        }, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true };
+    }
+
+    qz_nodiscard static ResourceAccess input_access(const std::size_t resource, const VkFormat format) noexcept {
+        return { resource, {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+            deduce_read_only_layout(aspect_from_format(format))
+        }, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT, true };
+    }
+
+    qz_nodiscard static ResourceAccess sample_access(const std::size_t resource, const VkFormat format) noexcept {
+        return { resource, {
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            deduce_read_only_layout(aspect_from_format(format))
+        }, VK_IMAGE_USAGE_SAMPLED_BIT, false };
+    }
+
+    qz_nodiscard static bool intersects(const std::vector<std::string>& lhs, const std::vector<std::string>& rhs) noexcept {
+        return std::any_of(lhs.begin(), lhs.end(), [&rhs](const auto& name) {
+            return std::find(rhs.begin(), rhs.end(), name) != rhs.end();
+        });
+    }
+
+    // Merges the dependency into an existing one between the same subpasses, a render pass ends up with at most one per pair.
+    static void add_dependency(std::vector<SubpassDependency>& dependencies,
+                               const std::uint32_t source,
+                               const std::uint32_t dest,
+                               const ResourceUsage& from,
+                               const ResourceUsage& to,
+                               const VkDependencyFlags flags) noexcept {
+        const auto source_stage = from.stage ? from.stage : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        const auto source_access = from.access & write_accesses;
+        for (auto& each : dependencies) {
+            if (each.source_subpass == source && each.dest_subpass == dest) {
+                each.source_stage |= source_stage;
+                each.dest_stage |= to.stage;
+                each.source_access |= source_access;
+                each.dest_access |= to.access;
+                each.flags &= flags;
+                return;
+            }
+        }
+        dependencies.push_back({ source, dest, source_stage, to.stage, source_access, to.access, flags });
+    }
+
+    qz_nodiscard RenderGraph RenderGraph::create(const Context& context, CreateInfo&& info) noexcept {
+        RenderGraph graph{};
+        graph.passes = std::move(info.passes);
+        graph.resources.reserve(info.images.size());
+        for (auto&& each : info.images) {
+            graph.resources.push_back({ std::move(each), {} });
+        }
+
+        const auto find = [&graph](const std::string_view name) noexcept -> std::size_t {
+            for (std::size_t index = 0; index < graph.resources.size(); ++index) {
+                if (graph.resources[index].info.name == name) {
+                    return index;
+                }
+            }
+            qz_force_assert("Render graph resource not found");
+        };
+        const auto resource_count = graph.resources.size();
+        graph.output = find(info.output);
+
+        // Walk the passes backwards from the output, a pass survives only if something needed reads what it writes.
+        std::vector<bool> needed(resource_count);
+        std::vector<std::size_t> alive;
+        needed[graph.output] = true;
+        for (auto index = graph.passes.size(); index-- > 0;) {
+            const auto& pass = graph.passes[index];
+            if (std::none_of(pass.writes.begin(), pass.writes.end(), [&](const auto& name) { return needed[find(name)]; })) {
+                continue;
+            }
+            alive.emplace_back(index);
+            for (const auto& name : pass.inputs) {
+                needed[find(name)] = true;
+            }
+            for (const auto& name : pass.samples) {
+                needed[find(name)] = true;
+            }
+        }
+        std::reverse(alive.begin(), alive.end());
+
+        // Consecutive passes become subpasses of the same render pass as long as they share the extent
+        // and none of them samples what another one renders to.
+        std::vector<std::vector<std::size_t>> groups;
+        VkExtent2D group_extent{};
+        for (const auto index : alive) {
+            const auto& pass = graph.passes[index];
+            const auto& target = graph.resources[find(pass.writes[0])].info;
+            const auto merge = !groups.empty() &&
+                group_extent.width == target.width &&
+                group_extent.height == target.height &&
+                std::none_of(groups.back().begin(), groups.back().end(), [&](const auto other) {
+                    const auto& previous = graph.passes[other];
+                    return intersects(pass.samples, previous.writes) || intersects(previous.samples, pass.writes);
+                });
+            if (merge) {
+                groups.back().emplace_back(index);
+            } else {
+                groups.push_back({ index });
+                group_extent = { target.width, target.height };
+            }
+        }
+
+        // Accesses of every subpass of every render pass, and the range of render passes each resource lives in.
+        std::vector<std::vector<std::vector<ResourceAccess>>> accesses(groups.size());
+        std::vector<std::size_t> first_use(resource_count, unused);
+        std::vector<std::size_t> last_use(resource_count, 0);
+        std::vector<ResourceUsage> final_usage(resource_count);
+        std::vector<VkImageUsageFlags> image_usage(resource_count);
+        for (std::size_t group = 0; group < groups.size(); ++group) {
+            for (const auto index : groups[group]) {
+                const auto& pass = graph.passes[index];
+                auto& subpass = accesses[group].emplace_back();
+                for (const auto& name : pass.writes) {
+                    const auto resource = find(name);
+                    subpass.emplace_back(write_access(resource, graph.resources[resource].info.format));
+                }
+                for (const auto& name : pass.inputs) {
+                    const auto resource = find(name);
+                    subpass.emplace_back(input_access(resource, graph.resources[resource].info.format));
+                }
+                for (const auto& name : pass.samples) {
+                    const auto resource = find(name);
+                    subpass.emplace_back(sample_access(resource, graph.resources[resource].info.format));
+                }
+                for (const auto& access : subpass) {
+                    first_use[access.resource] = std::min(first_use[access.resource], group);
+                    last_use[access.resource] = std::max(last_use[access.resource], group);
+                    final_usage[access.resource] = access.usage;
+                    image_usage[access.resource] |= access.flags;
+                }
+            }
+        }
+        qz_assert(first_use[graph.output] != unused, "No pass writes the render graph output");
+        // The output is copied into the swapchain after every pass.
+        last_use[graph.output] = groups.size();
+        final_usage[graph.output] = transfer_usage;
+        image_usage[graph.output] |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+
+        // Images whose lifetimes don't overlap share memory, biggest images are placed first.
+        struct MemorySlot {
+            VkMemoryRequirements requirements;
+            std::vector<std::size_t> resources;
+        };
+
+        std::vector<std::size_t> order;
+        std::vector<VkMemoryRequirements> requirements(resource_count);
+        for (std::size_t resource = 0; resource < resource_count; ++resource) {
+            if (first_use[resource] == unused) {
+                continue;
+            }
+            auto& each = graph.resources[resource];
+            each.image = Image::create_unbound(context, {
+                .width = each.info.width,
+                .height = each.info.height,
+                .mips = 1,
+                .format = each.info.format,
+                .usage = image_usage[resource]
+            });
+            vkGetImageMemoryRequirements(context.device, each.image.handle, &requirements[resource]);
+            order.emplace_back(resource);
+        }
+        std::sort(order.begin(), order.end(), [&requirements](const auto lhs, const auto rhs) {
+            return requirements[lhs].size > requirements[rhs].size;
+        });
+
+        std::vector<MemorySlot> slots;
+        std::vector<std::size_t> slot_of(resource_count);
+        for (const auto resource : order) {
+            const auto& required = requirements[resource];
+            const auto slot = std::find_if(slots.begin(), slots.end(), [&](const MemorySlot& each) {
+                return (each.requirements.memoryTypeBits & required.memoryTypeBits) &&
+                    std::all_of(each.resources.begin(), each.resources.end(), [&](const auto other) {
+                        return last_use[other] < first_use[resource] || last_use[resource] < first_use[other];
+                    });
+            });
+            if (slot == slots.end()) {
+                slot_of[resource] = slots.size();
+                slots.push_back({ required, { resource } });
+            } else {
+                slot->requirements.size = std::max(slot->requirements.size, required.size);
+                slot->requirements.alignment = std::max(slot->requirements.alignment, required.alignment);
+                slot->requirements.memoryTypeBits &= required.memoryTypeBits;
+                slot->resources.emplace_back(resource);
+                slot_of[resource] = slot - slots.begin();
+            }
+        }
+
+        VmaAllocationCreateInfo allocation_create_info{};
+        allocation_create_info.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        for (const auto& slot : slots) {
+            VmaAllocation allocation;
+            qz_vulkan_check(vmaAllocateMemory(context.allocator, &slot.requirements, &allocation_create_info, &allocation, nullptr));
+            for (const auto resource : slot.resources) {
+                Image::bind(context, graph.resources[resource].image, allocation);
+            }
+            graph.memory.emplace_back(allocation);
+        }
+
+        // What the first access of a resource in a frame waits for: its own last access in the previous frame,
+        // and the last access of every image sharing its memory.
+        const auto frame_source = [&](const std::size_t resource) noexcept {
+            auto usage = final_usage[resource];
+            for (const auto other : slots[slot_of[resource]].resources) {
+                usage.stage |= final_usage[other].stage;
+                usage.access |= final_usage[other].access;
+            }
+            return usage;
+        };
+
+        // Layout transitions are folded into the render passes: each attachment is left in the layout of its next use,
+        // so the only explicit barriers left are the subpass dependencies between actual producers and consumers.
+        std::vector<VkImageLayout> layouts(resource_count, VK_IMAGE_LAYOUT_UNDEFINED);
+        std::vector<std::optional<ResourceUsage>> last_usage(resource_count);
+        graph.physical_passes.reserve(groups.size());
+        for (std::size_t group = 0; group < groups.size(); ++group) {
+            const auto& subpass_accesses = accesses[group];
+            const auto next_usage = [&](const std::size_t resource) noexcept -> std::optional<ResourceUsage> {
+                for (auto later = group + 1; later < groups.size(); ++later) {
+                    for (const auto& subpass : accesses[later]) {
+                        for (const auto& access : subpass) {
+                            if (access.resource == resource) {
+                                return access.usage;
+                            }
+                        }
+                    }
+                }
+                if (resource == graph.output) {
+                    return transfer_usage;
+                }
+                return std::nullopt;
+            };
+            const auto is_attachment_of = [&](const std::size_t subpass, const std::size_t resource) noexcept {
+                return std::any_of(subpass_accesses[subpass].begin(), subpass_accesses[subpass].end(), [resource](const auto& access) {
+                    return access.attachment && access.resource == resource;
+                });
+            };
+
+            std::vector<std::size_t> attachments;
+            std::vector<SubpassDependency> dependencies;
+            std::vector<std::optional<std::pair<std::uint32_t, ResourceUsage>>> in_pass(resource_count);
+            for (std::uint32_t subpass = 0; subpass < subpass_accesses.size(); ++subpass) {
+                for (const auto& access : subpass_accesses[subpass]) {
+                    const auto resource = access.resource;
+                    if (access.attachment && std::find(attachments.begin(), attachments.end(), resource) == attachments.end()) {
+                        attachments.emplace_back(resource);
+                    }
+
+                    if (const auto& previous = in_pass[resource]) {
+                        if (previous->first != subpass) {
+                            add_dependency(dependencies, previous->first, subpass, previous->second, access.usage, VK_DEPENDENCY_BY_REGION_BIT);
+                        }
+                    } else {
+                        const auto source = last_usage[resource] ? *last_usage[resource] : frame_source(resource);
+                        add_dependency(dependencies, meta::external_subpass, subpass, source, access.usage, {});
+                    }
+                    in_pass[resource] = std::make_pair(subpass, access.usage);
+                }
+            }
+
+            RenderPass::CreateInfo render_pass_info{};
+            for (const auto resource : attachments) {
+                const auto& each = graph.resources[resource];
+                const auto& [last_subpass, last] = *in_pass[resource];
+                const auto next = next_usage(resource);
+                const auto final_layout = next ? next->layout : last.layout;
+                render_pass_info.attachments.push_back({
+                    .image = each.image,
+                    .name = each.info.name,
+                    .framebuffer = 0,
+                    .owning = false,
+                    // Nothing reads it after this render pass, its contents never have to be stored.
+                    .discard = !next,
+                    .layout = final_layout,
+                    .clear = first_use[resource] == group ? each.info.clear : ClearValue{},
+                    .initial_layout = layouts[resource]
+                });
+                if (final_layout != last.layout) {
+                    // The final layout transition has to be visible to whoever uses the image next.
+                    add_dependency(dependencies, last_subpass, meta::external_subpass, last, *next, {});
+                }
+                layouts[resource] = final_layout;
+            }
+
+            for (std::size_t subpass = 0; subpass < groups[group].size(); ++subpass) {
+                const auto& pass = graph.passes[groups[group][subpass]];
+                auto& subpass_info = render_pass_info.subpasses.emplace_back();
+                subpass_info.attachments = pass.writes;
+                subpass_info.input = pass.inputs;
+                for (const auto resource : attachments) {
+                    if (is_attachment_of(subpass, resource)) {
+                        continue;
+                    }
+                    bool before = false;
+                    bool after = false;
+                    for (std::size_t other = 0; other < subpass_accesses.size(); ++other) {
+                        if (is_attachment_of(other, resource)) {
+                            (other < subpass ? before : after) = true;
+                        }
+                    }
+                    if (before && after) {
+                        subpass_info.preserve.emplace_back(graph.resources[resource].info.name);
+                    }
+                }
+            }
+            render_pass_info.dependencies = std::move(dependencies);
+
+            for (std::size_t resource = 0; resource < resource_count; ++resource) {
+                if (in_pass[resource]) {
+                    last_usage[resource] = in_pass[resource]->second;
+                }
+            }
+            graph.physical_passes.push_back({
+                RenderPass::create(context, std::move(render_pass_info)),
+                groups[group]
+            });
+        }
+
+        return graph;
+    }
+
+    void RenderGraph::destroy(const Context& context, RenderGraph& graph) noexcept {
+        for (auto& each : graph.physical_passes) {
+            RenderPass::destroy(context, each.render_pass);
+        }
+        for (auto& each : graph.resources) {
+            // Images don't own their memory, it's freed below.
+            if (each.image.handle) {
+                Image::destroy(context, each.image);
+            }
+        }
+        for (const auto each : graph.memory) {
+            vmaFreeMemory(context.allocator, each);
+        }
+        graph = {};
+    }
+
+    qz_nodiscard const Image& RenderGraph::image(const std::string_view name) const noexcept {
+        for (const auto& each : resources) {
+            if (each.info.name == name) {
+                return each.image;
+            }
+        }
+        qz_force_assert("Render graph resource not found");
+    }
+
+    qz_nodiscard const RenderPass& RenderGraph::render_pass(const std::string_view name) const noexcept {
+        for (const auto& each : physical_passes) {
+            for (const auto index : each.subpasses) {
+                if (passes[index].name == name) {
+                    return each.render_pass;
+                }
+            }
+        }
+        qz_force_assert("Render graph pass not found or culled");
+    }
+
+    qz_nodiscard std::uint32_t RenderGraph::subpass(const std::string_view name) const noexcept {
+        for (const auto& each : physical_passes) {
+            for (std::uint32_t subpass = 0; subpass < each.subpasses.size(); ++subpass) {
+                if (passes[each.subpasses[subpass]].name == name) {
+                    return subpass;
+                }
+            }
+        }
+        qz_force_assert("Render graph pass not found or culled");
+    }
+
+    void RenderGraph::execute(CommandBuffer& command_buffer, const FrameInfo& frame) const noexcept {
+        for (const auto& each : physical_passes) {
+            for (std::uint32_t subpass = 0; subpass < each.subpasses.size(); ++subpass) {
+                const auto& pass = passes[each.subpasses[subpass]];
+                if (subpass == 0) {
+                    command_buffer.begin_render_pass(each.render_pass, 0, pass.contents);
+                } else {
+                    command_buffer.next_subpass(pass.contents);
+                }
+                pass.record(command_buffer, each.render_pass, subpass, frame);
+            }
+            command_buffer.end_render_pass();
+        }
+
+        // The output was left in TRANSFER_SRC_OPTIMAL by its last render pass, only the swapchain image needs barriers.
+        ImageMemoryBarrier transfer_transition{};
+        transfer_transition.image = frame.image;
+        transfer_transition.source_family = meta::family_ignored;
+        transfer_transition.dest_family = meta::family_ignored;
+        transfer_transition.source_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        transfer_transition.dest_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        transfer_transition.source_access = {};
+        transfer_transition.dest_access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        transfer_transition.old_layout = VK_IMAGE_LAYOUT_UNDEFINED;
+        transfer_transition.new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+
+        ImageMemoryBarrier present_transition{};
+        present_transition.image = frame.image;
+        present_transition.source_family = meta::family_ignored;
+        present_transition.dest_family = meta::family_ignored;
+        present_transition.source_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        present_transition.dest_stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        present_transition.source_access = VK_ACCESS_TRANSFER_WRITE_BIT;
+        present_transition.dest_access = {};
+        present_transition.old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        present_transition.new_layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+        command_buffer
+            .insert_layout_transition(transfer_transition)
+            .copy_image(resources[output].image, *frame.image)
+            .insert_layout_transition(present_transition);
+    }
+} // namespace qz::gfx
\ No newline at end of file
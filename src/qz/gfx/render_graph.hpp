@@ -0,0 +1,78 @@
+#pragma once
+
+#include <qz/gfx/render_pass.hpp>
+#include <qz/util/macros.hpp>
+#include <qz/gfx/clear.hpp>
+#include <qz/gfx/image.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <vulkan/vulkan.h>
+#include <vk_mem_alloc.h>
+
+#include <string_view>
+#include <functional>
+#include <cstdint>
+#include <vector>
+#include <string>
+
+namespace qz::gfx {
+    // Records a pass, the command buffer is already inside the pass' subpass.
+    using RecordPassFunction = std::function<void(CommandBuffer&, const RenderPass&, std::uint32_t, const FrameInfo&)>;
+
+    struct RenderGraph {
+        struct ImageInfo {
+            std::string name;
+            std::uint32_t width;
+            std::uint32_t height;
+            VkFormat format;
+            ClearValue clear;
+        };
+
+        struct PassInfo {
+            std::string name;
+            // Attachments the pass renders to.
+            std::vector<std::string> writes;
+            // Pixel local reads, the pass can become a subpass of the render pass writing them.
+            std::vector<std::string> inputs;
+            // Arbitrary reads, the render pass writing them has to end first.
+            std::vector<std::string> samples;
+            VkSubpassContents contents;
+            RecordPassFunction record;
+        };
+
+        struct CreateInfo {
+            std::vector<ImageInfo> images;
+            std::vector<PassInfo> passes;
+            // Copied into the swapchain image every frame, passes it doesn't depend on are culled.
+            std::string output;
+        };
+
+        struct Resource {
+            ImageInfo info;
+            Image image;
+        };
+
+        // Passes merged into the subpasses of a single VkRenderPass.
+        struct PhysicalPass {
+            RenderPass render_pass;
+            std::vector<std::size_t> subpasses;
+        };
+
+        std::vector<Resource> resources;
+        std::vector<PassInfo> passes;
+        std::vector<PhysicalPass> physical_passes;
+        // Memory shared by images whose lifetimes don't overlap.
+        std::vector<VmaAllocation> memory;
+        std::size_t output;
+
+        qz_nodiscard static RenderGraph create(const Context&, CreateInfo&&) noexcept;
+        static void destroy(const Context&, RenderGraph&) noexcept;
+
+        qz_nodiscard const Image& image(std::string_view) const noexcept;
+        qz_nodiscard const RenderPass& render_pass(std::string_view) const noexcept;
+        qz_nodiscard std::uint32_t subpass(std::string_view) const noexcept;
+
+        // Records every pass that wasn't culled and copies the output into the frame's swapchain image.
+        void execute(CommandBuffer&, const FrameInfo&) const noexcept;
+    };
+} // namespace qz::gfx
\ No newline at end of file
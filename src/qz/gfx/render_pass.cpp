@@ -4,7 +4,7 @@
 #include <optional>
 
 namespace qz::gfx {
-    qz_nodiscard static VkImageLayout deduce_reference_layout(const VkImageAspectFlags aspect) noexcept {
+    qz_nodiscard VkImageLayout deduce_reference_layout(const VkImageAspectFlags aspect) noexcept {
         switch (aspect) {
             case VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_DEPTH_BIT:
                 return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
@@ -19,6 +19,13 @@ namespace qz::gfx {
         return VK_IMAGE_LAYOUT_UNDEFINED;
     }
 
+    qz_nodiscard VkImageLayout deduce_read_only_layout(const VkImageAspectFlags aspect) noexcept {
+        if (aspect & (VK_IMAGE_ASPECT_STENCIL_BIT | VK_IMAGE_ASPECT_DEPTH_BIT)) {
+            return VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+        }
+        return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
     qz_nodiscard RenderPass RenderPass::create(const Context& context, CreateInfo&& info) noexcept {
         RenderPass render_pass;
 
@@ -42,7 +49,7 @@ namespace qz::gfx {
                                  VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_DONT_CARE,
                 .stencilStoreOp = (attachment.image.aspect & VK_IMAGE_ASPECT_STENCIL_BIT) && each.discard ?
                                   VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
-                .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .initialLayout = each.initial_layout,
                 .finalLayout = each.layout,
             };
             attachment.reference = {
@@ -81,7 +88,11 @@ namespace qz::gfx {
             }
 
             for (const auto& name : each.input) {
-                storage.input_attachments.emplace_back(render_pass.attachment(name).reference);
+                const auto& attachment = render_pass.attachment(name);
+                storage.input_attachments.push_back({
+                    .attachment = attachment.reference.attachment,
+                    .layout = deduce_read_only_layout(attachment.image.aspect)
+                });
             }
 
             for (const auto& name : each.preserve) {
@@ -112,7 +123,7 @@ namespace qz::gfx {
             dependency.dstStageMask = each.dest_stage;
             dependency.srcAccessMask = each.source_access;
             dependency.dstAccessMask = each.dest_access;
-            dependency.dependencyFlags = {};
+            dependency.dependencyFlags = each.flags;
 
             dependencies.emplace_back(dependency);
         }
@@ -21,6 +21,7 @@ namespace qz::gfx {
             bool discard;
             VkImageLayout layout;
             ClearValue clear;
+            VkImageLayout initial_layout;
         };
         Image image;
         bool owning;
@@ -44,8 +45,14 @@ namespace qz::gfx {
         VkPipelineStageFlags dest_stage;
         VkAccessFlags source_access;
         VkAccessFlags dest_access;
+        VkDependencyFlags flags;
     };
 
+    // Layout an attachment with the given aspect is in while it's rendered to.
+    qz_nodiscard VkImageLayout deduce_reference_layout(VkImageAspectFlags) noexcept;
+    // Layout an attachment with the given aspect is in while it's read as an input attachment or sampled.
+    qz_nodiscard VkImageLayout deduce_read_only_layout(VkImageAspectFlags) noexcept;
+
     class RenderPass {
         VkRenderPass _handle = nullptr;
         std::vector<Attachment> _attachments;
@@ -4,6 +4,8 @@
 #include <qz/gfx/renderer.hpp>
 #include <qz/gfx/image.hpp>
 
+#include <qz/task/scheduler.hpp>
+
 namespace qz::gfx {
     qz_nodiscard Renderer Renderer::create(const Context& context, const Window& window) noexcept {
         Renderer renderer{};
@@ -11,20 +13,6 @@ namespace qz::gfx {
         // Create swapchain.
         renderer.swapchain = Swapchain::create(context, window);
 
-        // Allocate rendering command buffers.
-        VkCommandBufferAllocateInfo command_buffer_allocate_info{};
-        command_buffer_allocate_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        command_buffer_allocate_info.commandPool = context.main_pool;
-        command_buffer_allocate_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        command_buffer_allocate_info.commandBufferCount = meta::in_flight;
-
-        meta::in_flight_array<VkCommandBuffer> command_buffers{};
-        qz_vulkan_check(vkAllocateCommandBuffers(context.device, &command_buffer_allocate_info, &command_buffers[0]));
-
-        for (std::uint32_t index = 0; const auto& each : command_buffers) {
-            renderer.gfx_cmds[index++] = CommandBuffer::from_raw(context.main_pool, each);
-        }
-
         // Fence info.
         VkFenceCreateInfo fence_create_info{};
         fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
@@ -41,6 +29,22 @@ namespace qz::gfx {
             qz_vulkan_check(vkCreateFence(context.device, &fence_create_info, nullptr, &renderer.cmd_wait[i]));
         }
 
+        // Async compute pools and the timeline tracking their submissions.
+        VkCommandPoolCreateInfo command_pool_create_info{};
+        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        command_pool_create_info.queueFamilyIndex = context.compute_family;
+        for (auto& each : renderer.compute_pools) {
+            qz_vulkan_check(vkCreateCommandPool(context.device, &command_pool_create_info, nullptr, &each.handle));
+        }
+
+        VkSemaphoreTypeCreateInfo semaphore_type_create_info{};
+        semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphore_type_create_info.initialValue = 0;
+        semaphore_create_info.pNext = &semaphore_type_create_info;
+        qz_vulkan_check(vkCreateSemaphore(context.device, &semaphore_create_info, nullptr, &renderer.compute_done));
+
         return renderer;
     }
 
@@ -52,13 +56,30 @@ namespace qz::gfx {
             vkDestroySemaphore(context.device, renderer.gfx_done[i], nullptr);
             vkDestroyFence(context.device, renderer.cmd_wait[i], nullptr);
         }
+        for (const auto& each : renderer.compute_pools) {
+            vkDestroyCommandPool(context.device, each.handle, nullptr);
+        }
+        vkDestroySemaphore(context.device, renderer.compute_done, nullptr);
     }
 
     qz_nodiscard std::pair<CommandBuffer, FrameInfo> acquire_next_frame(Renderer& renderer, const Context& context) noexcept {
         qz_vulkan_check(vkAcquireNextImageKHR(context.device, renderer.swapchain.handle, -1, renderer.img_ready[renderer.frame_idx], nullptr, &renderer.image_idx));
         qz_vulkan_check(vkWaitForFences(context.device, 1, &renderer.cmd_wait[renderer.frame_idx], true, -1));
+        task::reset_command_pools(context, renderer.frame_idx);
+
+        // Compute work is usually done by now, unless the graphics work of its frame never waited for it.
+        if (auto& pool = renderer.compute_pools[renderer.frame_idx]; pool.used != 0) {
+            VkSemaphoreWaitInfo wait_info{};
+            wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            wait_info.semaphoreCount = 1;
+            wait_info.pSemaphores = &renderer.compute_done;
+            wait_info.pValues = &pool.value;
+            qz_vulkan_check(vkWaitSemaphores(context.device, &wait_info, -1));
+            qz_vulkan_check(vkResetCommandPool(context.device, pool.handle, 0));
+            pool.used = 0;
+        }
 
-        return { renderer.gfx_cmds[renderer.frame_idx], {
+        return { task::acquire_command_buffer(context, renderer.frame_idx, VK_COMMAND_BUFFER_LEVEL_PRIMARY), {
             renderer.frame_idx,
             renderer.image_idx,
             renderer.img_ready[renderer.frame_idx],
@@ -68,13 +89,52 @@ namespace qz::gfx {
         } };
     }
 
-    void present_frame(Renderer& renderer, const Context& context, const CommandBuffer& command_buffer, const FrameInfo& frame) noexcept {
-        VkPipelineStageFlags wait_mask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    qz_nodiscard CommandBuffer acquire_compute_command_buffer(Renderer& renderer, const Context& context, const FrameInfo& frame) noexcept {
+        auto& pool = renderer.compute_pools[frame.index];
+        if (pool.used == pool.command_buffers.size()) {
+            pool.command_buffers.emplace_back(CommandBuffer::allocate(context, pool.handle));
+        }
+        return pool.command_buffers[pool.used++];
+    }
+
+    qz_nodiscard std::uint64_t submit_compute(Renderer& renderer, const Context& context, const CommandBuffer& command_buffer, const FrameInfo& frame) noexcept {
+        const auto value = ++renderer.compute_value;
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info{};
+        timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_submit_info.signalSemaphoreValueCount = 1;
+        timeline_submit_info.pSignalSemaphoreValues = &value;
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = &timeline_submit_info;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = command_buffer.ptr_handle();
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &renderer.compute_done;
+        qz_vulkan_check(vkQueueSubmit(context.compute, 1, &submit_info, nullptr));
+
+        renderer.compute_pools[frame.index].value = value;
+        return value;
+    }
+
+    void present_frame(Renderer& renderer, const Context& context, const CommandBuffer& command_buffer, const FrameInfo& frame, const std::uint64_t compute) noexcept {
+        // Binary semaphores ignore their timeline value.
+        const VkSemaphore wait_semaphores[] = { frame.img_ready, renderer.compute_done };
+        const VkPipelineStageFlags wait_masks[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT };
+        const std::uint64_t wait_values[] = { 0, compute };
+        const auto wait_count = compute != 0 ? 2u : 1u;
+
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info{};
+        timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_submit_info.waitSemaphoreValueCount = wait_count;
+        timeline_submit_info.pWaitSemaphoreValues = wait_values;
+
         VkSubmitInfo submit_info{};
         submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.pWaitDstStageMask = &wait_mask;
-        submit_info.waitSemaphoreCount = 1;
-        submit_info.pWaitSemaphores = &frame.img_ready;
+        submit_info.pNext = &timeline_submit_info;
+        submit_info.pWaitDstStageMask = wait_masks;
+        submit_info.waitSemaphoreCount = wait_count;
+        submit_info.pWaitSemaphores = wait_semaphores;
         submit_info.commandBufferCount = 1;
         submit_info.pCommandBuffers = command_buffer.ptr_handle();
         submit_info.signalSemaphoreCount = 1;
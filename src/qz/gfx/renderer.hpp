@@ -21,23 +21,44 @@ namespace qz::gfx {
         const Image* image;
     };
 
+    // Command buffers for the async compute queue, recycled once the frame's compute work has finished.
+    struct ComputePool {
+        VkCommandPool handle;
+        std::vector<CommandBuffer> command_buffers;
+        std::size_t used;
+        // Last timeline value submitted from this pool.
+        std::uint64_t value;
+    };
+
     struct Renderer {
         Swapchain swapchain;
 
         std::uint32_t image_idx;
         std::uint32_t frame_idx;
 
-        meta::in_flight_array<CommandBuffer> gfx_cmds;
         meta::in_flight_array<VkSemaphore> img_ready;
         meta::in_flight_array<VkSemaphore> gfx_done;
         meta::in_flight_array<VkFence> cmd_wait;
 
+        meta::in_flight_array<ComputePool> compute_pools;
+        // Timeline signaled by every async compute submission.
+        VkSemaphore compute_done;
+        std::uint64_t compute_value;
+
         qz_nodiscard static Renderer create(const Context&, const Window&) noexcept;
         static void destroy(const Context&, Renderer&) noexcept;
     };
 
+    // Waits for the frame's fence, resets its command pools and hands out a fresh primary from the calling thread.
     qz_nodiscard std::pair<CommandBuffer, FrameInfo> acquire_next_frame(Renderer&, const Context&) noexcept;
 
-    void present_frame(Renderer&, const Context&, const CommandBuffer&, const FrameInfo&) noexcept;
+    // Hands out a primary command buffer for the async compute queue, valid until the same frame comes around again.
+    qz_nodiscard CommandBuffer acquire_compute_command_buffer(Renderer&, const Context&, const FrameInfo&) noexcept;
+    // Submits to the compute queue and returns the timeline value signaled once it's done. Must be called from
+    // the thread presenting frames, since the compute queue may alias the graphics one.
+    qz_nodiscard std::uint64_t submit_compute(Renderer&, const Context&, const CommandBuffer&, const FrameInfo&) noexcept;
+
+    // The frame's graphics work waits for the given async compute value before indirect draws are read, 0 waits for nothing.
+    void present_frame(Renderer&, const Context&, const CommandBuffer&, const FrameInfo&, std::uint64_t = 0) noexcept;
     void wait_queue(VkQueue) noexcept;
 } // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,36 @@
+#include <qz/gfx/shader_store.hpp>
+
+#include <qz/util/mapped_file.hpp>
+
+#include <unordered_map>
+#include <string>
+#include <mutex>
+
+namespace qz::gfx {
+    // Pipelines are compiled on workers, lookups and insertions happen concurrently.
+    static std::mutex shaders_mutex;
+    static std::unordered_map<std::string, util::MappedFile> shaders;
+
+    qz_nodiscard std::span<const std::uint32_t> shader_binary(const char* path) noexcept {
+        std::lock_guard<std::mutex> lock(shaders_mutex);
+        auto [it, inserted] = shaders.try_emplace(path);
+        if (inserted) {
+            it->second = util::MappedFile::create(path);
+        }
+
+        // Mappings are page aligned, the words can be read in place.
+        const auto& file = it->second;
+        if (file.size % sizeof(std::uint32_t) != 0) {
+            qz_force_assert("SPIR-V binary size is not a multiple of 4");
+        }
+        return { static_cast<const std::uint32_t*>(file.data), file.size / sizeof(std::uint32_t) };
+    }
+
+    void destroy_shaders() noexcept {
+        std::lock_guard<std::mutex> lock(shaders_mutex);
+        for (auto& [_, each] : shaders) {
+            util::MappedFile::destroy(each);
+        }
+        shaders = {};
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <span>
+
+namespace qz::gfx {
+    // Maps the SPIR-V binary on first use, later requests for the same path reuse the mapping.
+    // The view stays valid until destroy_shaders() and can be handed straight to vkCreateShaderModule.
+    qz_nodiscard std::span<const std::uint32_t> shader_binary(const char*) noexcept;
+
+    void destroy_shaders() noexcept;
+} // namespace qz::gfx
\ No newline at end of file
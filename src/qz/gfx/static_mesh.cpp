@@ -1,22 +1,70 @@
-#include <qz/gfx/command_buffer.hpp>
+#include <qz/gfx/mesh_simplifier.hpp>
+#include <qz/gfx/mesh_optimizer.hpp>
 #include <qz/gfx/static_mesh.hpp>
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/gfx/bindless.hpp>
 #include <qz/gfx/context.hpp>
 #include <qz/gfx/assets.hpp>
+#include <qz/gfx/upload.hpp>
 
+#include <qz/util/mapped_file.hpp>
+#include <qz/task/completion.hpp>
 #include <qz/task/scheduler.hpp>
 #include <qz/meta/types.hpp>
 
+#include <algorithm>
 #include <cstring>
+#include <limits>
+#include <string>
 
 namespace qz::gfx {
+    // Large sections are split so they stream through the staging ring instead of needing a dedicated buffer.
+    constexpr auto mesh_upload_chunk = static_cast<std::size_t>(4 * 1024 * 1024);
+
+    qz_nodiscard static VkIndexType index_type(const std::size_t index_size) noexcept {
+        return index_size == sizeof(std::uint16_t) ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
     struct TaskData {
         const Context* context;
         meta::Handle<StaticMesh> handle;
         std::vector<float> vertices;
         std::vector<std::uint32_t> indices;
+        std::vector<VertexAttribute> attributes;
+        bool optimize;
+        std::uint32_t lods;
     };
 
+    qz_nodiscard static StaticMesh make_static_mesh(const GeometryAllocation& allocation,
+                                                    const std::uint32_t stride,
+                                                    const std::size_t index_size,
+                                                    const std::span<const MeshLod> lods,
+                                                    const MeshBounds& bounds) noexcept {
+        StaticMesh mesh{};
+        mesh.geometry = allocation;
+        mesh.vertex_offset = allocation.vertex_offset / stride;
+        mesh.lod_count = lods.size();
+        for (std::size_t i = 0; i < lods.size(); ++i) {
+            mesh.lods[i] = lods[i];
+            mesh.lods[i].first_index += allocation.index_offset / index_size;
+        }
+        mesh.index_type = index_type(index_size);
+        mesh.bounds = bounds;
+        return mesh;
+    }
+
     qz_nodiscard meta::Handle<StaticMesh> request_static_mesh(const Context& context, StaticMesh::CreateInfo&& info) noexcept {
+        // The vertex stride places the mesh in the geometry block, a mesh without attributes has none.
+        if (info.attributes.empty()) {
+            qz_force_assert("Meshes need at least one vertex attribute");
+        }
+        // A trailing partial vertex would be packed past the end of the geometry.
+        if (info.geometry.size() % vertex_components(info.attributes) != 0) {
+            qz_force_assert("Vertex data doesn't match the attributes");
+        }
+        if (info.indices.empty() || info.indices.size() % 3 != 0) {
+            qz_force_assert("Mesh has no whole triangles");
+        }
         const auto result = assets::emplace_empty<StaticMesh>();
 
         auto task_data = new TaskData{
@@ -24,79 +72,202 @@ namespace qz::gfx {
             result,
             std::move(info.geometry),
             std::move(info.indices),
+            std::move(info.attributes),
+            info.optimize,
+            info.lods
         };
 
+        task::begin_loader_task();
         task::get_scheduler().AddTask(ftl::Task{
-            .Function = +[](ftl::TaskScheduler* scheduler, void* ptr) {
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
                 const auto data = reinterpret_cast<TaskData*>(ptr);
-                const auto thread_index = scheduler->GetCurrentThreadIndex();
-                auto command_buffer = CommandBuffer::allocate(*data->context, task::get_command_pool(thread_index));
-
-                auto vertex_staging = Buffer::create(*data->context, {
-                    .flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .capacity = data->vertices.size() * sizeof(float)
+                const auto components = vertex_components(data->attributes);
+                // Checked before anything reads them, narrowing to 16 bits would otherwise wrap them onto other vertices.
+                const auto in_range = std::all_of(data->indices.begin(), data->indices.end(), [count = data->vertices.size() / components](const std::uint32_t index) {
+                    return index < count;
                 });
-                std::memcpy(vertex_staging.mapped, data->vertices.data(), vertex_staging.capacity);
+                if (!in_range) {
+                    qz_force_assert("Mesh index out of range");
+                }
+                MeshOptimization optimization{};
+                if (data->optimize) {
+                    optimization = optimize_mesh(data->vertices, components, data->indices);
+                }
+                // Every level indexes the same vertices, they are appended after the full detail indices.
+                const auto lods = generate_lods(data->vertices, components, data->indices, data->lods);
+                if (data->optimize) {
+                    std::vector<std::uint32_t> clusters;
+                    for (std::size_t i = 1; i < lods.size(); ++i) {
+                        const auto range = std::span(data->indices).subspan(lods[i].first_index, lods[i].index_count);
+                        optimize_vertex_cache(range, data->vertices.size() / components, clusters);
+                    }
+                }
+                const auto stride = vertex_stride(data->attributes);
+                const auto vertex_count = data->vertices.size() / components;
+                const auto geometry_size = vertex_count * stride;
 
-                auto index_staging = Buffer::create(*data->context, {
-                    .flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                    .usage = VMA_MEMORY_USAGE_CPU_ONLY,
-                    .capacity = data->indices.size() * sizeof(std::uint32_t)
-                });
-                std::memcpy(index_staging.mapped, data->indices.data(), index_staging.capacity);
+                // Packed attributes are converted here, plain float layouts are uploaded as they are.
+                std::vector<char> packed;
+                const void* vertices = data->vertices.data();
+                if (geometry_size != data->vertices.size() * sizeof(float)) {
+                    packed.resize(geometry_size);
+                    pack_vertices(data->vertices, data->attributes, packed.data());
+                    vertices = packed.data();
+                }
 
-                auto geometry = Buffer::create(*data->context, {
-                    .flags = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                    .usage = VMA_MEMORY_USAGE_GPU_ONLY,
-                    .capacity = vertex_staging.capacity
-                });
-                auto indices = Buffer::create(*data->context, {
-                    .flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                    .usage = VMA_MEMORY_USAGE_GPU_ONLY,
-                    .capacity = index_staging.capacity
-                });
+                // Indices are narrowed whenever every vertex is addressable with 16 bits.
+                std::vector<std::uint16_t> narrow;
+                const void* indices = data->indices.data();
+                auto index_size = sizeof(std::uint32_t);
+                if (vertex_count <= std::numeric_limits<std::uint16_t>::max() + 1) {
+                    narrow.assign(data->indices.begin(), data->indices.end());
+                    indices = narrow.data();
+                    index_size = sizeof(std::uint16_t);
+                }
+                const auto indices_size = data->indices.size() * index_size;
+
+                const auto allocation = allocate_geometry(*data->context, geometry_size, stride, indices_size, index_size);
+                const auto& block = geometry_block(allocation.block);
+                auto& mesh = assets::from_handle(data->handle);
+                mesh = make_static_mesh(allocation, stride, index_size, lods, compute_bounds(data->vertices, components));
+                mesh.optimization = optimization;
+                // The whole block is bound, gl_VertexIndex already includes the draw's vertexOffset.
+                write_bindless_buffer(*data->context, data->handle.index, block.vertices);
 
-                command_buffer
-                    .begin()
-                        .copy_buffer(vertex_staging, geometry)
-                        .copy_buffer(index_staging, indices)
-                    .end();
-
-                VkFence done{};
-                VkFenceCreateInfo fence_create_info{};
-                fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-                qz_vulkan_check(vkCreateFence(data->context->device, &fence_create_info, nullptr, &done));
-
-                VkSubmitInfo submit_info{};
-                submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-                submit_info.pWaitDstStageMask = nullptr;
-                submit_info.waitSemaphoreCount = 0;
-                submit_info.pWaitSemaphores = nullptr;
-                submit_info.commandBufferCount = 1;
-                submit_info.pCommandBuffers = command_buffer.ptr_handle();
-                submit_info.signalSemaphoreCount = 0;
-                submit_info.pSignalSemaphores = nullptr;
-
-                {
-                    std::lock_guard<std::mutex> lock(task::get_transfer_mutex());
-                    qz_vulkan_check(vkQueueSubmit(data->context->transfer, 1, &submit_info, done));
-                    while (vkGetFenceStatus(data->context->device, done) != VK_SUCCESS);
-                    vkResetFences(data->context->device, 1, &done);
-                    vkDestroyFence(data->context->device, done, nullptr);
-                }
-                assets::from_handle(data->handle) = {
-                    geometry,
-                    indices
+                // Copies are merged with every other pending upload and submitted in one batch,
+                // the handle is finalized once the batch's timeline value is reached.
+                const BufferUpload uploads[] = {
+                    { vertices, geometry_size, block.vertices.handle, allocation.vertex_offset },
+                    { indices, indices_size, block.indices.handle, allocation.index_offset }
                 };
-                assets::finalize(data->handle);
-                Buffer::destroy(*data->context, vertex_staging);
-                Buffer::destroy(*data->context, index_staging);
-                CommandBuffer::destroy(*data->context, command_buffer);
+                upload_buffers(*data->context, uploads, [handle = data->handle]() noexcept {
+                    assets::finalize(handle);
+                });
                 delete data;
+                task::end_loader_task();
             },
             .ArgData = task_data
         }, ftl::TaskPriority::High);
         return result;
     }
+
+    struct FileTaskData {
+        const Context* context;
+        meta::Handle<StaticMesh> handle;
+        std::string path;
+    };
+
+    static void append_chunks(std::vector<BufferUpload>& uploads, const char* data, const std::size_t size, VkBuffer dest, const std::size_t offset) noexcept {
+        for (std::size_t position = 0; position < size; position += mesh_upload_chunk) {
+            uploads.push_back({ data + position, std::min(mesh_upload_chunk, size - position), dest, offset + position });
+        }
+    }
+
+    // Indices read from a file must address the mesh's own vertices, the GPU would otherwise read other meshes' ones.
+    template <typename T>
+    qz_nodiscard static bool indices_in_range(const char* data, const std::size_t count, const std::uint32_t vertex_count) noexcept {
+        for (std::size_t i = 0; i < count; ++i) {
+            T index;
+            std::memcpy(&index, data + i * sizeof(T), sizeof(T));
+            if (index >= vertex_count) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    qz_nodiscard meta::Handle<StaticMesh> request_static_mesh(const Context& context, const char* path) noexcept {
+        const auto result = assets::emplace_empty<StaticMesh>();
+
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<FileTaskData*>(ptr);
+                auto file = util::MappedFile::create(data->path.c_str());
+                const auto bytes = static_cast<const char*>(file.data);
+                // Files come from disk, every check holds in release builds too.
+                if (file.size < sizeof(MeshFileHeader)) {
+                    qz_force_assert("Truncated mesh file");
+                }
+                const auto& header = *static_cast<const MeshFileHeader*>(file.data);
+                if (header.magic != mesh_file_magic) {
+                    qz_force_assert("Not a mesh file");
+                }
+                if (header.version != mesh_file_version) {
+                    qz_force_assert("Unsupported mesh file version");
+                }
+                if (header.attribute_count < 1 || header.attribute_count > mesh_file_max_attributes) {
+                    qz_force_assert("Invalid vertex attribute count");
+                }
+                if (header.lod_count < 1 || header.lod_count > max_mesh_lods) {
+                    qz_force_assert("Invalid level of detail count");
+                }
+                if (header.index_size != sizeof(std::uint16_t) && header.index_size != sizeof(std::uint32_t)) {
+                    qz_force_assert("Unsupported index size");
+                }
+                if (header.vertex_count == 0 || header.index_count == 0 || header.index_count % 3 != 0) {
+                    qz_force_assert("Mesh file has no triangles");
+                }
+
+                std::uint32_t stride = 0;
+                for (std::uint32_t i = 0; i < header.attribute_count; ++i) {
+                    if (header.attributes[i] >= vertex_attribute_count) {
+                        qz_force_assert("Unknown vertex attribute");
+                    }
+                    stride += attribute_size(static_cast<VertexAttribute>(header.attributes[i]));
+                }
+                const auto vertices_size = static_cast<std::size_t>(header.vertex_count) * stride;
+                const auto indices_size = static_cast<std::size_t>(header.index_count) * header.index_size;
+                // Offsets are compared before being added to, a huge one must not wrap around.
+                if (header.vertex_offset > file.size || vertices_size > file.size - header.vertex_offset ||
+                    header.index_offset > file.size || indices_size > file.size - header.index_offset) {
+                    qz_force_assert("Truncated mesh file");
+                }
+                for (std::uint32_t i = 0; i < header.lod_count; ++i) {
+                    const auto& lod = header.lods[i];
+                    if (lod.index_count > header.index_count || lod.first_index > header.index_count - lod.index_count) {
+                        qz_force_assert("Level of detail out of the index section");
+                    }
+                    if (lod.index_count == 0 || lod.index_count % 3 != 0) {
+                        qz_force_assert("Level of detail has no whole triangles");
+                    }
+                }
+                const auto index_data = bytes + header.index_offset;
+                const auto valid = header.index_size == sizeof(std::uint16_t) ?
+                    indices_in_range<std::uint16_t>(index_data, header.index_count, header.vertex_count) :
+                    indices_in_range<std::uint32_t>(index_data, header.index_count, header.vertex_count);
+                if (!valid) {
+                    qz_force_assert("Index out of the vertex section");
+                }
+
+                const auto allocation = allocate_geometry(*data->context, vertices_size, stride, indices_size, header.index_size);
+                const auto& block = geometry_block(allocation.block);
+                assets::from_handle(data->handle) = make_static_mesh(allocation, stride, header.index_size, { header.lods, header.lod_count }, header.bounds);
+                write_bindless_buffer(*data->context, data->handle.index, block.vertices);
+
+                // Sections are copied from the mapping into staging memory by upload_buffers, which is
+                // the only copy the data goes through. The file can be unmapped as soon as it returns.
+                std::vector<BufferUpload> uploads;
+                append_chunks(uploads, bytes + header.vertex_offset, vertices_size, block.vertices.handle, allocation.vertex_offset);
+                append_chunks(uploads, bytes + header.index_offset, indices_size, block.indices.handle, allocation.index_offset);
+                upload_buffers(*data->context, uploads, [handle = data->handle]() noexcept {
+                    assets::finalize(handle);
+                });
+                util::MappedFile::destroy(file);
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = new FileTaskData{ &context, result, path }
+        }, ftl::TaskPriority::High);
+        return result;
+    }
+
+    qz_nodiscard std::uint32_t select_lod(const StaticMesh& mesh, const float distance, const float projection_scale, const float pixels) noexcept {
+        // Errors grow with every level, the first one that's too coarse ends the search.
+        std::uint32_t lod = 0;
+        while (lod + 1 < mesh.lod_count && mesh.lods[lod + 1].error * projection_scale <= pixels * distance) {
+            ++lod;
+        }
+        return lod;
+    }
 } // namespace qz::gfx
\ No newline at end of file
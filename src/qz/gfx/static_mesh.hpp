@@ -3,20 +3,52 @@
 #include <qz/util/macros.hpp>
 #include <qz/util/fwd.hpp>
 
-#include <qz/gfx/buffer.hpp>
+#include <qz/gfx/mesh_optimizer.hpp>
+#include <qz/gfx/mesh_format.hpp>
+#include <qz/gfx/geometry.hpp>
+#include <qz/gfx/pipeline.hpp>
+
+#include <vulkan/vulkan.h>
 
 #include <cstdint>
 #include <vector>
+#include <array>
 
 namespace qz::gfx {
     struct StaticMesh {
         struct CreateInfo {
             std::vector<float> geometry;
             std::vector<std::uint32_t> indices;
+            std::vector<VertexAttribute> attributes;
+            // Deduplicates and reorders geometry for vertex cache, overdraw and fetch locality before uploading.
+            bool optimize;
+            // Levels of detail to generate including the full detail one, 0 and 1 keep only the full detail mesh.
+            std::uint32_t lods;
         };
-        Buffer geometry;
-        Buffer indices;
+        GeometryAllocation geometry;
+        std::uint32_t vertex_offset;
+        // Index ranges relative to the geometry block, level 0 is full detail.
+        std::array<MeshLod, max_mesh_lods> lods;
+        std::uint32_t lod_count;
+        VkIndexType index_type;
+        MeshBounds bounds;
+        // Vertex cache statistics of the full detail level, zero unless the mesh was optimized when loaded.
+        MeshOptimization optimization;
     };
 
     qz_nodiscard meta::Handle<StaticMesh> request_static_mesh(const Context&, StaticMesh::CreateInfo&&) noexcept;
+    // Maps a .qzm file on a worker and streams its sections into staging memory without intermediate copies.
+    qz_nodiscard meta::Handle<StaticMesh> request_static_mesh(const Context&, const char*) noexcept;
+
+    // Picks the coarsest level whose error projects to at most the given number of pixels at the given distance.
+    // The projection scale is viewport height / (2 * tan(vertical fov / 2)).
+    qz_nodiscard std::uint32_t select_lod(const StaticMesh&, float, float, float = 1.0f) noexcept;
+
+    // View levels of detail are selected for, distances are measured from the camera to each instance's
+    // bounding sphere center and divided by the instance's scale.
+    struct LodSettings {
+        float camera[3];
+        float projection_scale;
+        float pixels = 1.0f;
+    };
 } // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,317 @@
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/texture.hpp>
+#include <qz/gfx/context.hpp>
+#include <qz/gfx/assets.hpp>
+#include <qz/gfx/upload.hpp>
+#include <qz/gfx/image.hpp>
+
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+#include <qz/meta/types.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+
+namespace qz::gfx {
+    // "DDS " read as a little-endian word.
+    constexpr auto dds_magic = static_cast<std::uint32_t>(0x20534444);
+    constexpr auto dds_fourcc_flag = static_cast<std::uint32_t>(0x4);
+    constexpr auto dds_rgb_flag = static_cast<std::uint32_t>(0x40);
+    constexpr auto dds_cubemap_caps = static_cast<std::uint32_t>(0x200);
+    constexpr auto dds_volume_caps = static_cast<std::uint32_t>(0x200000);
+    constexpr auto dds_dx10_texture2d = static_cast<std::uint32_t>(3);
+    constexpr auto dds_dx10_cube_flag = static_cast<std::uint32_t>(0x4);
+
+    constexpr std::uint8_t ktx2_identifier[] = {
+        0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a
+    };
+
+    struct DdsPixelFormat {
+        std::uint32_t size;
+        std::uint32_t flags;
+        std::uint32_t fourcc;
+        std::uint32_t bit_count;
+        std::uint32_t masks[4];
+    };
+
+    struct DdsHeader {
+        std::uint32_t magic;
+        std::uint32_t size;
+        std::uint32_t flags;
+        std::uint32_t height;
+        std::uint32_t width;
+        std::uint32_t pitch;
+        std::uint32_t depth;
+        std::uint32_t mip_count;
+        std::uint32_t reserved[11];
+        DdsPixelFormat format;
+        std::uint32_t caps[4];
+        std::uint32_t reserved_caps;
+    };
+    static_assert(sizeof(DdsHeader) == 128);
+
+    // Follows the header when the pixel format's four character code is "DX10".
+    struct DdsHeaderDx10 {
+        std::uint32_t dxgi_format;
+        std::uint32_t dimension;
+        std::uint32_t flags;
+        std::uint32_t array_size;
+        std::uint32_t flags2;
+    };
+
+    struct Ktx2Header {
+        std::uint8_t identifier[12];
+        std::uint32_t format;
+        std::uint32_t type_size;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t depth;
+        std::uint32_t layer_count;
+        std::uint32_t face_count;
+        std::uint32_t level_count;
+        std::uint32_t supercompression;
+        std::uint32_t dfd_offset;
+        std::uint32_t dfd_length;
+        std::uint32_t kvd_offset;
+        std::uint32_t kvd_length;
+        std::uint64_t sgd_offset;
+        std::uint64_t sgd_length;
+    };
+    static_assert(sizeof(Ktx2Header) == 80);
+
+    struct Ktx2Level {
+        std::uint64_t offset;
+        std::uint64_t length;
+        std::uint64_t uncompressed_length;
+    };
+
+    qz_nodiscard static constexpr std::uint32_t fourcc(const char (&code)[5]) noexcept {
+        return code[0] | (code[1] << 8) | (code[2] << 16) | (code[3] << 24);
+    }
+
+    qz_nodiscard static VkFormat dxgi_format(const std::uint32_t format) noexcept {
+        switch (format) {
+            case 28: return VK_FORMAT_R8G8B8A8_UNORM;
+            case 29: return VK_FORMAT_R8G8B8A8_SRGB;
+            case 71: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+            case 72: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+            case 77: return VK_FORMAT_BC3_UNORM_BLOCK;
+            case 78: return VK_FORMAT_BC3_SRGB_BLOCK;
+            case 80: return VK_FORMAT_BC4_UNORM_BLOCK;
+            case 83: return VK_FORMAT_BC5_UNORM_BLOCK;
+            case 84: return VK_FORMAT_BC5_SNORM_BLOCK;
+            case 87: return VK_FORMAT_B8G8R8A8_UNORM;
+            case 91: return VK_FORMAT_B8G8R8A8_SRGB;
+            case 98: return VK_FORMAT_BC7_UNORM_BLOCK;
+            case 99: return VK_FORMAT_BC7_SRGB_BLOCK;
+            default: break;
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    qz_nodiscard static VkFormat dds_format(const DdsPixelFormat& format) noexcept {
+        if (format.flags & dds_fourcc_flag) {
+            switch (format.fourcc) {
+                case fourcc("DXT1"): return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+                case fourcc("DXT5"): return VK_FORMAT_BC3_UNORM_BLOCK;
+                case fourcc("ATI1"):
+                case fourcc("BC4U"): return VK_FORMAT_BC4_UNORM_BLOCK;
+                case fourcc("ATI2"):
+                case fourcc("BC5U"): return VK_FORMAT_BC5_UNORM_BLOCK;
+                default: break;
+            }
+        } else if ((format.flags & dds_rgb_flag) && format.bit_count == 32 && format.masks[1] == 0x0000ff00 && format.masks[3] == 0xff000000) {
+            // Layouts without alpha, such as X8R8G8B8, would sample whatever the padding byte holds.
+            if (format.masks[0] == 0x000000ff && format.masks[2] == 0x00ff0000) {
+                return VK_FORMAT_R8G8B8A8_UNORM;
+            }
+            if (format.masks[0] == 0x00ff0000 && format.masks[2] == 0x000000ff) {
+                return VK_FORMAT_B8G8R8A8_UNORM;
+            }
+        }
+        return VK_FORMAT_UNDEFINED;
+    }
+
+    // Formats level_size knows, the ones upload_image can copy.
+    qz_nodiscard static bool is_supported_format(const VkFormat format) noexcept {
+        switch (format) {
+            case VK_FORMAT_R8G8B8A8_UNORM:
+            case VK_FORMAT_R8G8B8A8_SRGB:
+            case VK_FORMAT_B8G8R8A8_UNORM:
+            case VK_FORMAT_B8G8R8A8_SRGB:
+                return true;
+            default:
+                return is_block_compressed(format);
+        }
+    }
+
+    // Sizes and level counts are checked before any level is located, level_size only accepts known formats.
+    qz_nodiscard static const char* validate_layout(const TextureLayout& layout) noexcept {
+        if (!is_supported_format(layout.format)) {
+            return "Unsupported texture format";
+        }
+        if (layout.width == 0 || layout.height == 0) {
+            return "Empty texture";
+        }
+        if (layout.level_count > max_texture_levels || layout.level_count > max_mips(layout.width, layout.height)) {
+            return "Too many texture levels";
+        }
+        return nullptr;
+    }
+
+    // Levels are stored one after the other from mip 0, optionally after a DX10 header.
+    qz_nodiscard static const char* parse_dds(const char* bytes, const std::size_t size, TextureLayout& layout) noexcept {
+        const auto& header = *reinterpret_cast<const DdsHeader*>(bytes);
+        // caps[1] is DDSCAPS2, the faces of a cube map or the slices of a volume follow the first image.
+        if (header.depth > 1 || (header.caps[1] & dds_volume_caps)) {
+            return "Volume textures are not supported";
+        }
+        if (header.caps[1] & dds_cubemap_caps) {
+            return "Cube maps are not supported";
+        }
+        layout.width = header.width;
+        layout.height = header.height;
+        layout.level_count = std::max(header.mip_count, 1u);
+
+        auto offset = sizeof(DdsHeader);
+        if ((header.format.flags & dds_fourcc_flag) && header.format.fourcc == fourcc("DX10")) {
+            if (size < offset + sizeof(DdsHeaderDx10)) {
+                return "Truncated texture file";
+            }
+            const auto& extension = *reinterpret_cast<const DdsHeaderDx10*>(bytes + offset);
+            if (extension.dimension != dds_dx10_texture2d) {
+                return "Only 2D textures are supported";
+            }
+            if (extension.flags & dds_dx10_cube_flag) {
+                return "Cube maps are not supported";
+            }
+            if (extension.array_size > 1) {
+                return "Texture arrays are not supported";
+            }
+            layout.format = dxgi_format(extension.dxgi_format);
+            offset += sizeof(DdsHeaderDx10);
+        } else {
+            layout.format = dds_format(header.format);
+        }
+        if (const auto error = validate_layout(layout)) {
+            return error;
+        }
+
+        for (std::uint32_t mip = 0; mip < layout.level_count; ++mip) {
+            const auto level = level_size(layout.format, std::max(layout.width >> mip, 1u), std::max(layout.height >> mip, 1u));
+            if (level > size - offset) {
+                return "Truncated texture file";
+            }
+            layout.levels[mip] = { bytes + offset, level };
+            offset += level;
+        }
+        return nullptr;
+    }
+
+    // The level index gives each level's range, the format is stored as a VkFormat already.
+    qz_nodiscard static const char* parse_ktx2(const char* bytes, const std::size_t size, TextureLayout& layout) noexcept {
+        const auto& header = *reinterpret_cast<const Ktx2Header*>(bytes);
+        if (header.supercompression != 0) {
+            return "Supercompressed textures are not supported";
+        }
+        if (header.depth > 1 || header.layer_count > 1 || header.face_count != 1) {
+            return "Only 2D textures are supported";
+        }
+
+        layout.format = static_cast<VkFormat>(header.format);
+        layout.width = header.width;
+        layout.height = header.height;
+        // A level count of zero asks the loader to generate the mip chain.
+        layout.level_count = std::max(header.level_count, 1u);
+        if (const auto error = validate_layout(layout)) {
+            return error;
+        }
+        if (size - sizeof(Ktx2Header) < layout.level_count * sizeof(Ktx2Level)) {
+            return "Truncated texture file";
+        }
+
+        const auto* levels = reinterpret_cast<const Ktx2Level*>(bytes + sizeof(Ktx2Header));
+        for (std::uint32_t mip = 0; mip < layout.level_count; ++mip) {
+            const auto level = level_size(layout.format, std::max(layout.width >> mip, 1u), std::max(layout.height >> mip, 1u));
+            // The offset is compared before adding to it, a huge one must not wrap around.
+            if (levels[mip].length != level || levels[mip].offset > size || level > size - levels[mip].offset) {
+                return "Invalid texture level";
+            }
+            layout.levels[mip] = { bytes + levels[mip].offset, level };
+        }
+        return nullptr;
+    }
+
+    qz_nodiscard const char* parse_texture(const util::MappedFile& file, TextureLayout& layout) noexcept {
+        const auto bytes = static_cast<const char*>(file.data);
+        layout = {};
+        if (file.size >= sizeof(Ktx2Header) && std::memcmp(bytes, ktx2_identifier, sizeof(ktx2_identifier)) == 0) {
+            return parse_ktx2(bytes, file.size, layout);
+        }
+        if (file.size < sizeof(DdsHeader) || *reinterpret_cast<const std::uint32_t*>(bytes) != dds_magic) {
+            return "Not a texture file";
+        }
+        return parse_dds(bytes, file.size, layout);
+    }
+
+    struct TextureTaskData {
+        const Context* context;
+        meta::Handle<Image> handle;
+        std::string path;
+    };
+
+    qz_nodiscard meta::Handle<Image> request_texture(const Context& context, const char* path) noexcept {
+        const auto result = assets::emplace_empty<Image>();
+
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<TextureTaskData*>(ptr);
+                auto file = util::MappedFile::create(data->path.c_str());
+                TextureLayout layout;
+                if (const auto error = parse_texture(file, layout)) {
+                    qz_force_assert(error);
+                }
+
+                // Uncompressed textures without a full chain are completed by blitting from and to the image
+                // with linear filtering.
+                auto mips = layout.level_count;
+                VkImageUsageFlags usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+                if (!is_block_compressed(layout.format) && mips == 1) {
+                    VkFormatProperties properties;
+                    vkGetPhysicalDeviceFormatProperties(data->context->gpu, layout.format, &properties);
+                    constexpr auto blit_features =
+                        VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                        VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                        VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+                    if ((properties.optimalTilingFeatures & blit_features) != blit_features) {
+                        qz_force_assert("Format can't generate mips");
+                    }
+                    mips = max_mips(layout.width, layout.height);
+                    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                }
+
+                auto& image = assets::from_handle(data->handle);
+                image = Image::create(*data->context, {
+                    .width = layout.width,
+                    .height = layout.height,
+                    .mips = mips,
+                    .format = layout.format,
+                    .usage = usage
+                });
+
+                // Levels are copied from the mapping into staging memory, the file can be unmapped right after.
+                upload_image(*data->context, image, { layout.levels.data(), layout.level_count }, [context = data->context, handle = data->handle]() noexcept {
+                    write_bindless_image(*context, handle.index, assets::from_handle(handle));
+                    assets::finalize(handle);
+                });
+                util::MappedFile::destroy(file);
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = new TextureTaskData{ &context, result, path }
+        }, ftl::TaskPriority::High);
+        return result;
+    }
+} // namespace qz::gfx
\ No newline at end of file
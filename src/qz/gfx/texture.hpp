@@ -0,0 +1,35 @@
+#pragma once
+
+#include <qz/util/mapped_file.hpp>
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/gfx/upload.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <array>
+
+namespace qz::gfx {
+    // Enough levels for a 32768x32768 texture.
+    constexpr auto max_texture_levels = 16u;
+
+    // Where every level of a texture file lives, in order starting from mip 0. Levels point into the mapping.
+    struct TextureLayout {
+        VkFormat format;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t level_count;
+        std::array<ImageUpload, max_texture_levels> levels;
+    };
+
+    // Reads the header of a .dds or .ktx2 file and checks every level lies within it. Returns why the file
+    // was rejected, or nullptr once the layout is filled.
+    qz_nodiscard const char* parse_texture(const util::MappedFile&, TextureLayout&) noexcept;
+
+    // Maps a .dds or .ktx2 file on a worker and streams its levels into staging memory. BC1, BC3, BC4, BC5 and BC7
+    // payloads must contain their whole mip chain, 8 bit RGBA ones get the levels they lack generated on the GPU.
+    // Once finalized the image is sampleable and its view sits in the bindless table at the handle's index.
+    qz_nodiscard meta::Handle<Image> request_texture(const Context&, const char*) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include <qz/gfx/texture_streaming.hpp>
+#include <qz/gfx/bindless.hpp>
+#include <qz/gfx/context.hpp>
+#include <qz/gfx/texture.hpp>
+#include <qz/gfx/assets.hpp>
+#include <qz/gfx/upload.hpp>
+#include <qz/gfx/image.hpp>
+
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+#include <qz/meta/types.hpp>
+
+#include <unordered_map>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <deque>
+#include <mutex>
+
+namespace qz::gfx {
+    struct StreamedTexture {
+        meta::Handle<Image> handle;
+        util::MappedFile file;
+        TextureLayout layout;
+    };
+
+    // Image holding the texture's levels from top down, waiting for the render thread to swap it in.
+    struct FinishedImage {
+        std::uint32_t texture;
+        std::uint32_t top;
+        Image image;
+    };
+
+    struct LoadTaskData {
+        const Context* context;
+        std::uint32_t texture;
+        std::string path;
+    };
+
+    // Tasks get their own copy of the layout, the texture table may grow while they run.
+    struct StreamTaskData {
+        const Context* context;
+        std::uint32_t texture;
+        std::uint32_t top;
+        TextureLayout layout;
+    };
+
+    static StreamingSettings settings;
+    // Guards every texture's bookkeeping, loader and upload tasks only touch it to publish results.
+    static std::mutex streaming_mutex;
+    // Entries are never erased, indices handed to tasks stay valid. Residencies are indexed the same way.
+    static std::deque<StreamedTexture> textures;
+    static std::vector<TextureResidency> residencies;
+    static std::unordered_map<std::uint32_t, std::uint32_t> texture_slots;
+    static std::vector<FinishedImage> finished;
+    static std::vector<StreamingRequest> requests;
+    static std::vector<Image> expired;
+    static RetireQueue retired;
+    static std::size_t resident;
+    static std::size_t last_budget;
+    static std::uint64_t frame;
+
+    void RetireQueue::push(const std::uint64_t frame, const Image& image, const std::size_t bytes) noexcept {
+        _images.push_back({ frame, image, bytes });
+        _bytes += bytes;
+    }
+
+    void RetireQueue::collect(const std::uint64_t frame, std::vector<Image>& images) noexcept {
+        while (!_images.empty() && _images.front().frame + texture_retire_delay <= frame) {
+            images.emplace_back(_images.front().image);
+            _bytes -= _images.front().bytes;
+            _images.pop_front();
+        }
+    }
+
+    void RetireQueue::drain(std::vector<Image>& images) noexcept {
+        for (const auto& each : _images) {
+            images.emplace_back(each.image);
+        }
+        _images.clear();
+        _bytes = 0;
+    }
+
+    qz_nodiscard std::size_t RetireQueue::size() const noexcept {
+        return _images.size();
+    }
+
+    qz_nodiscard std::size_t RetireQueue::bytes() const noexcept {
+        return _bytes;
+    }
+
+    qz_nodiscard TextureResidency make_texture_residency(const TextureLayout& layout, const std::uint32_t tail_size) noexcept {
+        qz_assert((layout.level_count > 1 || std::max(layout.width, layout.height) <= tail_size), "Streamed textures must store their mips");
+        TextureResidency residency{};
+        for (std::uint32_t mip = 0; mip < layout.level_count; ++mip) {
+            residency.level_sizes[mip] = layout.levels[mip].size;
+        }
+        residency.level_count = layout.level_count;
+        residency.size = std::max(layout.width, layout.height);
+
+        // The tail starts at the first level small enough, or the last one if none is.
+        residency.tail = layout.level_count - 1;
+        for (std::uint32_t mip = 0; mip < layout.level_count; ++mip) {
+            if (std::max(layout.width >> mip, layout.height >> mip) <= tail_size) {
+                residency.tail = mip;
+                break;
+            }
+        }
+        residency.top = layout.level_count;
+        residency.wanted = residency.tail;
+        residency.incoming = static_cast<std::ptrdiff_t>(resident_size(residency, residency.tail));
+        residency.pending = true;
+        return residency;
+    }
+
+    qz_nodiscard std::size_t resident_size(const TextureResidency& residency, const std::uint32_t top) noexcept {
+        std::size_t size = 0;
+        for (auto mip = top; mip < residency.level_count; ++mip) {
+            size += residency.level_sizes[mip];
+        }
+        return size;
+    }
+
+    void record_texture_usage(TextureResidency& residency, const float pixels, const std::uint64_t frame) noexcept {
+        residency.last_used = frame;
+        if (!residency.loaded) {
+            return;
+        }
+
+        // Level whose size matches the screen footprint, a texel per pixel.
+        const auto size = static_cast<float>(residency.size);
+        const auto level = pixels <= 0 ? residency.tail : static_cast<std::uint32_t>(std::max(std::floor(std::log2(size / pixels)), 0.0f));
+        residency.wanted = std::min({ residency.wanted, level, residency.tail });
+    }
+
+    void finish_texture_upload(TextureResidency& residency, const std::uint32_t top) noexcept {
+        residency.bytes = resident_size(residency, top);
+        residency.top = top;
+        residency.incoming = 0;
+        residency.pending = false;
+        residency.loaded = true;
+    }
+
+    static void request_levels(TextureResidency& residency, const std::uint32_t index, const std::uint32_t top, std::vector<StreamingRequest>& requests) noexcept {
+        residency.pending = true;
+        residency.incoming = static_cast<std::ptrdiff_t>(resident_size(residency, top)) - static_cast<std::ptrdiff_t>(residency.bytes);
+        requests.push_back({ index, top });
+    }
+
+    void plan_texture_streaming(const std::span<TextureResidency> residencies, const std::size_t resident, const std::size_t retiring, const std::size_t budget, std::vector<StreamingRequest>& requests) noexcept {
+        // Evictions aim at what stays resident once pending uploads are swapped in. Memory only comes back once the
+        // replaced images retire, until then refinements count them along with every image being uploaded.
+        auto target = resident;
+        auto committed = resident + retiring;
+        for (const auto& each : residencies) {
+            target += each.incoming;
+            if (each.pending) {
+                committed += each.bytes + each.incoming;
+            }
+        }
+
+        // Drops one level at a time from the least recently used textures, mip tails are never evicted.
+        std::vector<std::uint32_t> candidates;
+        for (std::uint32_t i = 0; i < residencies.size(); ++i) {
+            const auto& residency = residencies[i];
+            if (residency.loaded && !residency.pending && residency.top < residency.tail) {
+                candidates.emplace_back(i);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [residencies](const auto lhs, const auto rhs) {
+            return residencies[lhs].last_used < residencies[rhs].last_used;
+        });
+        for (const auto index : candidates) {
+            if (target <= budget) {
+                break;
+            }
+            auto& residency = residencies[index];
+            target -= residency.level_sizes[residency.top];
+            committed += resident_size(residency, residency.top + 1);
+            request_levels(residency, index, residency.top + 1, requests);
+        }
+
+        // Textures are refined towards what they were last reported to need, only if the levels fit.
+        for (std::uint32_t i = 0; i < residencies.size(); ++i) {
+            auto& residency = residencies[i];
+            if (residency.loaded && !residency.pending && residency.wanted < residency.top) {
+                const auto size = resident_size(residency, residency.wanted);
+                if (committed + size <= budget) {
+                    committed += size;
+                    request_levels(residency, i, residency.wanted, requests);
+                }
+            }
+            residency.wanted = residency.tail;
+        }
+    }
+
+    // Without VK_EXT_memory_budget the configured value is used, otherwise textures get whatever the rest of the
+    // process leaves of the device local heaps' budget. Usage includes resident and retiring textures, which are given back.
+    qz_nodiscard static std::size_t current_budget(const Context& context) noexcept {
+        if (!context.memory_budget) {
+            return settings.budget;
+        }
+
+        const VkPhysicalDeviceMemoryProperties* properties;
+        vmaGetMemoryProperties(context.allocator, &properties);
+        VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+        vmaGetBudget(context.allocator, budgets);
+        std::size_t budget = 0;
+        std::size_t usage = 0;
+        for (std::uint32_t i = 0; i < properties->memoryHeapCount; ++i) {
+            if (properties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+                budget += budgets[i].budget;
+                usage += budgets[i].usage;
+            }
+        }
+        const auto available = static_cast<std::size_t>(budget * settings.budget_fraction);
+        const auto others = usage - std::min(usage, resident + retired.bytes());
+        return available - std::min(available, others);
+    }
+
+    // Uploads the texture's levels from top down into a new image, which is swapped in by the next update
+    // after the upload finishes. The residency must already be marked pending. Must be called with streaming_mutex held.
+    static void stream_levels(const Context& context, const std::uint32_t index, const std::uint32_t top) noexcept {
+        const auto& texture = textures[index];
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<StreamTaskData*>(ptr);
+                const auto& layout = data->layout;
+                const auto top = data->top;
+                const auto image = Image::create(*data->context, {
+                    .width = std::max(layout.width >> top, 1u),
+                    .height = std::max(layout.height >> top, 1u),
+                    .mips = layout.level_count - top,
+                    .format = layout.format,
+                    .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT
+                });
+                upload_image(*data->context, image, { layout.levels.data() + top, layout.level_count - top }, [index = data->texture, top, image]() noexcept {
+                    std::lock_guard<std::mutex> lock(streaming_mutex);
+                    finished.push_back({ index, top, image });
+                });
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = new StreamTaskData{ &context, index, top, texture.layout }
+        }, ftl::TaskPriority::Normal);
+    }
+
+    void initialize_texture_streaming(const Context&, const StreamingSettings& info) noexcept {
+        settings = info;
+        resident = 0;
+        frame = 0;
+    }
+
+    qz_nodiscard meta::Handle<Image> request_streamed_texture(const Context& context, const char* path) noexcept {
+        const auto result = assets::emplace_empty<Image>();
+        std::uint32_t index;
+        {
+            std::lock_guard<std::mutex> lock(streaming_mutex);
+            index = textures.size();
+            textures.emplace_back().handle = result;
+            residencies.emplace_back().pending = true;
+            texture_slots[result.index] = index;
+        }
+
+        task::begin_loader_task();
+        task::get_scheduler().AddTask(ftl::Task{
+            .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                const auto data = reinterpret_cast<LoadTaskData*>(ptr);
+                auto file = util::MappedFile::create(data->path.c_str());
+                TextureLayout layout;
+                if (const auto error = parse_texture(file, layout)) {
+                    qz_force_assert(error);
+                }
+                auto residency = make_texture_residency(layout, settings.tail_size);
+
+                std::lock_guard<std::mutex> lock(streaming_mutex);
+                auto& texture = textures[data->texture];
+                texture.file = file;
+                texture.layout = layout;
+                // Usage may have been reported while the file was parsed.
+                residency.last_used = residencies[data->texture].last_used;
+                residencies[data->texture] = residency;
+                stream_levels(*data->context, data->texture, residency.tail);
+                delete data;
+                task::end_loader_task();
+            },
+            .ArgData = new LoadTaskData{ &context, index, path }
+        }, ftl::TaskPriority::High);
+        return result;
+    }
+
+    void report_texture_usage(const meta::Handle<Image> handle, const float pixels) noexcept {
+        std::lock_guard<std::mutex> lock(streaming_mutex);
+        const auto it = texture_slots.find(handle.index);
+        qz_assert(it != texture_slots.end(), "Not a streamed texture");
+        record_texture_usage(residencies[it->second], pixels, frame);
+    }
+
+    void update_texture_streaming(const Context& context) noexcept {
+        std::lock_guard<std::mutex> lock(streaming_mutex);
+        frame++;
+        // VMA refreshes its budget from the driver when the frame index changes.
+        vmaSetCurrentFrameIndex(context.allocator, frame);
+
+        for (const auto& each : finished) {
+            const auto& texture = textures[each.texture];
+            auto& residency = residencies[each.texture];
+            auto& image = assets::from_handle(texture.handle);
+            const auto loaded = residency.loaded;
+            if (loaded) {
+                // Frames in flight may still sample the old image until every frame's set has the new one.
+                replace_bindless_image(texture.handle.index, each.image);
+                retired.push(frame, image, residency.bytes);
+            } else {
+                write_bindless_image(context, texture.handle.index, each.image);
+            }
+            image = each.image;
+            resident -= residency.bytes;
+            finish_texture_upload(residency, each.top);
+            resident += residency.bytes;
+            if (!loaded) {
+                assets::finalize(texture.handle);
+            }
+        }
+        finished.clear();
+
+        retired.collect(frame, expired);
+        for (auto& each : expired) {
+            Image::destroy(context, each);
+        }
+        expired.clear();
+
+        last_budget = current_budget(context);
+        requests.clear();
+        plan_texture_streaming(residencies, resident, retired.bytes(), last_budget, requests);
+        for (const auto& each : requests) {
+            stream_levels(context, each.texture, each.top);
+        }
+    }
+
+    qz_nodiscard StreamingStatistics texture_streaming_statistics() noexcept {
+        std::lock_guard<std::mutex> lock(streaming_mutex);
+        StreamingStatistics statistics{};
+        statistics.resident = resident;
+        statistics.retiring = retired.bytes();
+        statistics.budget = last_budget;
+        for (const auto& each : residencies) {
+            statistics.pending += each.pending;
+        }
+        return statistics;
+    }
+
+    void destroy_texture_streaming(const Context& context) noexcept {
+        std::lock_guard<std::mutex> lock(streaming_mutex);
+        // Current images belong to the asset table, only the ones never swapped in or waiting to retire are freed here.
+        for (auto& each : finished) {
+            Image::destroy(context, each.image);
+        }
+        retired.drain(expired);
+        for (auto& each : expired) {
+            Image::destroy(context, each);
+        }
+        for (auto& each : textures) {
+            if (each.file.data) {
+                util::MappedFile::destroy(each.file);
+            }
+        }
+        finished = {};
+        requests = {};
+        expired = {};
+        textures = {};
+        residencies = {};
+        texture_slots = {};
+        resident = 0;
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/meta/constants.hpp>
+#include <qz/gfx/texture.hpp>
+#include <qz/gfx/image.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <array>
+#include <span>
+
+namespace qz::gfx {
+    // Replacements reach the last frame's set within in_flight frames, which may then still be executing.
+    constexpr auto texture_retire_delay = static_cast<std::uint64_t>(2 * meta::in_flight);
+
+    struct StreamingSettings {
+        // Bytes resident textures may take when the device can't report its memory budget.
+        std::size_t budget = static_cast<std::size_t>(512 * 1024 * 1024);
+        // Share of the reported device local budget the process allows itself, the rest is headroom.
+        float budget_fraction = 0.9f;
+        // Levels at most this large along their longest edge form the mip tail, loaded first and never evicted.
+        std::uint32_t tail_size = 128;
+    };
+
+    struct StreamingStatistics {
+        std::size_t resident;
+        std::size_t retiring;
+        std::size_t budget;
+        std::uint32_t pending;
+    };
+
+    // Everything the streaming policy knows about a texture, kept apart from its file and image.
+    struct TextureResidency {
+        std::array<std::size_t, max_texture_levels> level_sizes;
+        std::uint32_t level_count;
+        // Longest edge of mip 0.
+        std::uint32_t size;
+        // First level of the mip tail and most detailed resident level, level_count while nothing is resident.
+        std::uint32_t tail;
+        std::uint32_t top;
+        // Most detailed level reported since the last update.
+        std::uint32_t wanted;
+        std::uint64_t last_used;
+        // Resident bytes, and how many more the pending upload will take once swapped in.
+        std::size_t bytes;
+        std::ptrdiff_t incoming;
+        bool loaded;
+        bool pending;
+    };
+
+    // Upload of the texture's levels from top down into a new image.
+    struct StreamingRequest {
+        std::uint32_t texture;
+        std::uint32_t top;
+    };
+
+    // Images swapped out of the bindless table, held until no frame in flight can sample them.
+    class RetireQueue {
+        struct RetiredImage {
+            std::uint64_t frame;
+            Image image;
+            std::size_t bytes;
+        };
+
+        std::deque<RetiredImage> _images;
+        std::size_t _bytes = 0;
+    public:
+        // Takes the image and the bytes it holds, which stay allocated until it is collected.
+        void push(std::uint64_t, const Image&, std::size_t) noexcept;
+        // Moves out the images retired at least texture_retire_delay frames before the given one, oldest first.
+        void collect(std::uint64_t, std::vector<Image>&) noexcept;
+        // Moves out every image, once the device is idle.
+        void drain(std::vector<Image>&) noexcept;
+        qz_nodiscard std::size_t size() const noexcept;
+        qz_nodiscard std::size_t bytes() const noexcept;
+    };
+
+    // Residency of a texture whose mip tail, the levels at most the given size, is about to be uploaded.
+    qz_nodiscard TextureResidency make_texture_residency(const TextureLayout&, std::uint32_t) noexcept;
+    // Bytes taken by the given level and every smaller one.
+    qz_nodiscard std::size_t resident_size(const TextureResidency&, std::uint32_t) noexcept;
+    // Marks the texture used in the given frame, covering about the given number of pixels along its longest edge.
+    void record_texture_usage(TextureResidency&, float, std::uint64_t) noexcept;
+    // Makes the levels from the given one down resident once their upload finished.
+    void finish_texture_upload(TextureResidency&, std::uint32_t) noexcept;
+    // Takes the resident bytes, the bytes of replaced images not freed yet and the budget. Drops the top level of
+    // the least recently used textures while what stays resident once pending uploads are swapped in exceeds the
+    // budget, then refines textures towards the level last reported if the new image fits next to everything still
+    // allocated. Requested textures are marked pending and every texture's wanted level is reset to its mip tail.
+    void plan_texture_streaming(std::span<TextureResidency>, std::size_t, std::size_t, std::size_t, std::vector<StreamingRequest>&) noexcept;
+
+    void initialize_texture_streaming(const Context&, const StreamingSettings& = {}) noexcept;
+
+    // Maps a .dds or .ktx2 file whose mips are all stored and loads only its mip tail on a worker. More detailed
+    // levels are streamed in as usage is reported. The file stays mapped and the texture must not be released
+    // until streaming is destroyed.
+    qz_nodiscard meta::Handle<Image> request_streamed_texture(const Context&, const char*) noexcept;
+
+    // Reports the texture covers about the given number of pixels along its longest edge this frame, safe from any task.
+    void report_texture_usage(meta::Handle<Image>, float) noexcept;
+
+    // Called once per frame from the render thread after acquiring the frame. Swaps in images whose upload finished,
+    // frees the ones they replaced once no frame can sample them, evicts the top levels of the least recently used
+    // textures while over budget and requests the levels reported since the last call if they fit.
+    void update_texture_streaming(const Context&) noexcept;
+
+    qz_nodiscard StreamingStatistics texture_streaming_statistics() noexcept;
+    void destroy_texture_streaming(const Context&) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
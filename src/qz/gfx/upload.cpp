@@ -0,0 +1,444 @@
+#include <qz/gfx/command_buffer.hpp>
+#include <qz/gfx/context.hpp>
+#include <qz/gfx/buffer.hpp>
+#include <qz/gfx/upload.hpp>
+
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
+
+namespace qz::gfx {
+    // Size of the persistently mapped staging ring every upload is copied into.
+    constexpr auto staging_capacity = static_cast<std::size_t>(64 * 1024 * 1024);
+    constexpr auto staging_alignment = static_cast<std::size_t>(16);
+    constexpr auto no_position = static_cast<std::size_t>(-1);
+
+    struct PendingCopy {
+        VkBuffer source;
+        VkBuffer dest;
+        VkBufferCopy region;
+        std::size_t position;
+    };
+
+    // Staged levels of one image, recorded between the transitions that prepare and release it.
+    struct PendingImage {
+        VkBuffer source;
+        VkImage dest;
+        VkImageAspectFlags aspect;
+        std::uint32_t width;
+        std::uint32_t height;
+        std::uint32_t mips;
+        std::vector<VkBufferImageCopy> regions;
+        std::size_t position;
+    };
+
+    struct UploadBatch {
+        std::uint64_t value;
+        std::size_t staging_begin;
+        CommandBuffer command_buffer;
+        std::vector<Buffer> dedicated;
+        std::vector<std::function<void()>> callbacks;
+    };
+
+    static std::mutex pending_mutex;
+    static std::vector<PendingCopy> pending_copies;
+    static std::vector<PendingImage> pending_images;
+    static std::vector<Buffer> pending_dedicated;
+    static std::vector<std::function<void()>> pending_callbacks;
+
+    // Guards batch recording, submission order and retirement, flushes and polls may happen on any worker.
+    static std::mutex batch_mutex;
+    static std::deque<UploadBatch> in_flight;
+    static std::vector<CommandBuffer> free_command_buffers;
+    static VkCommandPool command_pool;
+    static VkSemaphore timeline;
+    static std::uint64_t timeline_value;
+
+    // Lower bound of the slice a scheduler thread is writing, no_position when it isn't writing one.
+    struct StagingWrite {
+        alignas(64) std::atomic<std::size_t> position;
+    };
+
+    static StagingRing staging;
+    // One per scheduler thread, a task never yields between allocating its slice and queueing the copy.
+    static std::vector<StagingWrite> staging_writes;
+
+    // Reclaims the ring up to the oldest slice still being written, referenced by a pending copy or by an unfinished batch.
+    // Must be called with batch_mutex held.
+    static void reclaim_staging() noexcept {
+        // Head must be read before the writes: a slice missing from them was allocated at or after it.
+        auto oldest = staging.current_head();
+        for (const auto& each : staging_writes) {
+            oldest = std::min(oldest, each.position.load(std::memory_order_acquire));
+        }
+
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        for (const auto& each : pending_copies) {
+            oldest = std::min(oldest, each.position);
+        }
+        for (const auto& each : pending_images) {
+            oldest = std::min(oldest, each.position);
+        }
+        for (const auto& each : in_flight) {
+            oldest = std::min(oldest, each.staging_begin);
+        }
+        staging.release(oldest);
+    }
+
+    void initialize_uploads(const Context& context) noexcept {
+        staging = StagingRing::create(context, {
+            .capacity = staging_capacity,
+            .alignment = staging_alignment
+        });
+        staging_writes = std::vector<StagingWrite>(task::get_scheduler().GetThreadCount());
+        for (auto& each : staging_writes) {
+            each.position.store(no_position, std::memory_order_relaxed);
+        }
+
+        VkCommandPoolCreateInfo command_pool_create_info{};
+        command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        command_pool_create_info.queueFamilyIndex = context.family;
+        qz_vulkan_check(vkCreateCommandPool(context.device, &command_pool_create_info, nullptr, &command_pool));
+
+        VkSemaphoreTypeCreateInfo semaphore_type_create_info{};
+        semaphore_type_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        semaphore_type_create_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        semaphore_type_create_info.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphore_create_info{};
+        semaphore_create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphore_create_info.pNext = &semaphore_type_create_info;
+        qz_vulkan_check(vkCreateSemaphore(context.device, &semaphore_create_info, nullptr, &timeline));
+    }
+
+    // Gives the writer a staging region of the given size, then passes its buffer, offset and ring position to the
+    // enqueue function with pending_mutex held, before the ring can be reclaimed past it. Allocations that can never
+    // fit in the ring get a dedicated staging buffer released with the batch.
+    template <typename W, typename E>
+    static void stage(const Context& context, const std::size_t size, W&& write, E&& enqueue) noexcept {
+        if (size > staging.max_allocation()) {
+            auto dedicated = Buffer::create(context, {
+                .flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                .usage = VMA_MEMORY_USAGE_CPU_ONLY,
+                .capacity = size
+            });
+            write(static_cast<char*>(dedicated.mapped));
+
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            enqueue(dedicated.handle, static_cast<std::size_t>(0), no_position);
+            pending_dedicated.emplace_back(dedicated);
+            return;
+        }
+
+        auto& current = staging_writes[task::get_scheduler().GetCurrentThreadIndex()].position;
+        while (true) {
+            // Published before allocating, the head only grows so the slice lies at or after it.
+            current.store(staging.current_head(), std::memory_order_release);
+            if (const auto slice = staging.allocate(size)) {
+                // The copy into mapped memory happens without any lock held.
+                write(static_cast<char*>(slice->mapped));
+                {
+                    std::lock_guard<std::mutex> lock(pending_mutex);
+                    enqueue(slice->handle, slice->offset, slice->position);
+                }
+                // The pending copy holds the slice from now on.
+                current.store(no_position, std::memory_order_release);
+                return;
+            }
+            current.store(no_position, std::memory_order_release);
+
+            // Ring is full: submit whatever is pending so it can drain, park until the GPU
+            // is done with it and retire the finished batches ourselves before trying again.
+            task::wait_timeline(context, timeline, flush_uploads(context));
+            poll_uploads(context);
+        }
+    }
+
+    void upload_buffers(const Context& context, const std::span<const BufferUpload> uploads, std::function<void()>&& callback) noexcept {
+        if (uploads.empty()) {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            pending_callbacks.emplace_back(std::move(callback));
+            return;
+        }
+        // The callback joins the last copy under the same lock, a flush in between would otherwise leave it behind.
+        for (const auto& each : uploads) {
+            const auto last = &each == &uploads.back();
+            stage(context, each.size, [&each](char* mapped) {
+                std::memcpy(mapped, each.data, each.size);
+            }, [&each, &callback, last](VkBuffer source, const std::size_t offset, const std::size_t position) {
+                pending_copies.push_back({ source, each.dest, { offset, each.offset, each.size }, position });
+                if (last) {
+                    pending_callbacks.emplace_back(std::move(callback));
+                }
+            });
+        }
+    }
+
+    void upload_image(const Context& context, const Image& image, const std::span<const ImageUpload> levels, std::function<void()>&& callback) noexcept {
+        qz_assert((1 <= levels.size() && levels.size() <= image.mips), "Invalid number of image levels");
+        qz_assert((levels.size() == image.mips || !is_block_compressed(image.format)), "Block compressed images can't generate their mips");
+
+        // Every level is staged in one allocation so the image is never split across batches.
+        std::vector<VkBufferImageCopy> regions;
+        std::size_t size = 0;
+        for (std::uint32_t mip = 0; mip < levels.size(); ++mip) {
+            qz_assert(levels[mip].size == level_size(image.format, std::max(image.width >> mip, 1u), std::max(image.height >> mip, 1u)), "Image level size mismatch");
+            regions.push_back({
+                .bufferOffset = size,
+                .bufferRowLength = 0,
+                .bufferImageHeight = 0,
+                .imageSubresource = { image.aspect, mip, 0, 1 },
+                .imageOffset = { 0, 0, 0 },
+                .imageExtent = { std::max(image.width >> mip, 1u), std::max(image.height >> mip, 1u), 1 }
+            });
+            size += (levels[mip].size + staging_alignment - 1) / staging_alignment * staging_alignment;
+        }
+
+        stage(context, size, [&](char* mapped) {
+            for (std::size_t i = 0; i < levels.size(); ++i) {
+                std::memcpy(mapped + regions[i].bufferOffset, levels[i].data, levels[i].size);
+            }
+        }, [&](VkBuffer source, const std::size_t offset, const std::size_t position) {
+            for (auto& each : regions) {
+                each.bufferOffset += offset;
+            }
+            pending_images.push_back({
+                .source = source,
+                .dest = image.handle,
+                .aspect = image.aspect,
+                .width = image.width,
+                .height = image.height,
+                .mips = image.mips,
+                .regions = std::move(regions),
+                .position = position
+            });
+            pending_callbacks.emplace_back(std::move(callback));
+        });
+    }
+
+    qz_nodiscard static VkImageMemoryBarrier make_level_barrier(const PendingImage& image,
+                                                                const std::uint32_t mip,
+                                                                const std::uint32_t count,
+                                                                const VkAccessFlags source_access,
+                                                                const VkAccessFlags dest_access,
+                                                                const VkImageLayout old_layout,
+                                                                const VkImageLayout new_layout) noexcept {
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = source_access;
+        barrier.dstAccessMask = dest_access;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image.dest;
+        barrier.subresourceRange = { image.aspect, mip, count, 0, 1 };
+        return barrier;
+    }
+
+    static void record_images(VkCommandBuffer command_buffer, const std::vector<PendingImage>& images) noexcept {
+        if (images.empty()) {
+            return;
+        }
+
+        std::vector<VkImageMemoryBarrier> barriers;
+        for (const auto& each : images) {
+            barriers.push_back(make_level_barrier(
+                each, 0, each.mips, 0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL));
+        }
+        vkCmdPipelineBarrier(
+            command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+
+        for (const auto& each : images) {
+            vkCmdCopyBufferToImage(
+                command_buffer, each.source, each.dest, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, each.regions.size(), each.regions.data());
+        }
+
+        // Each generated level is blitted from the previous one, which is moved to TRANSFER_SRC right before.
+        barriers.clear();
+        for (const auto& each : images) {
+            const auto levels = static_cast<std::uint32_t>(each.regions.size());
+            for (auto mip = levels; mip < each.mips; ++mip) {
+                const auto barrier = make_level_barrier(
+                    each, mip - 1, 1, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+                vkCmdPipelineBarrier(
+                    command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                    0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+                VkImageBlit blit{};
+                blit.srcSubresource = { each.aspect, mip - 1, 0, 1 };
+                blit.srcOffsets[1] = {
+                    static_cast<std::int32_t>(std::max(each.width >> (mip - 1), 1u)),
+                    static_cast<std::int32_t>(std::max(each.height >> (mip - 1), 1u)),
+                    1
+                };
+                blit.dstSubresource = { each.aspect, mip, 0, 1 };
+                blit.dstOffsets[1] = {
+                    static_cast<std::int32_t>(std::max(each.width >> mip, 1u)),
+                    static_cast<std::int32_t>(std::max(each.height >> mip, 1u)),
+                    1
+                };
+                vkCmdBlitImage(
+                    command_buffer,
+                    each.dest, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                    each.dest, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                    1, &blit, VK_FILTER_LINEAR);
+            }
+
+            // Levels used as blit sources are in TRANSFER_SRC, every other one is still in TRANSFER_DST.
+            const auto first_source = levels < each.mips ? levels - 1 : each.mips;
+            const auto last_source = each.mips - 1;
+            if (first_source != 0) {
+                barriers.push_back(make_level_barrier(
+                    each, 0, first_source, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+            }
+            if (first_source < last_source) {
+                barriers.push_back(make_level_barrier(
+                    each, first_source, last_source - first_source, VK_ACCESS_TRANSFER_READ_BIT, 0,
+                    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+            }
+            if (first_source < each.mips) {
+                barriers.push_back(make_level_barrier(
+                    each, last_source, 1, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL));
+            }
+        }
+        // Readers only start using the images once the batch's timeline value is reached.
+        vkCmdPipelineBarrier(
+            command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+            0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+    }
+
+    std::uint64_t flush_uploads(const Context& context) noexcept {
+        std::lock_guard<std::mutex> batch_lock(batch_mutex);
+        UploadBatch batch{};
+        std::vector<PendingCopy> copies;
+        std::vector<PendingImage> images;
+        {
+            std::lock_guard<std::mutex> lock(pending_mutex);
+            if (pending_copies.empty() && pending_images.empty() && pending_callbacks.empty()) {
+                return timeline_value;
+            }
+            copies = std::move(pending_copies);
+            images = std::move(pending_images);
+            batch.dedicated = std::move(pending_dedicated);
+            batch.callbacks = std::move(pending_callbacks);
+            batch.staging_begin = no_position;
+            for (const auto& each : copies) {
+                batch.staging_begin = std::min(batch.staging_begin, each.position);
+            }
+            for (const auto& each : images) {
+                batch.staging_begin = std::min(batch.staging_begin, each.position);
+            }
+            pending_copies = {};
+            pending_images = {};
+            pending_dedicated = {};
+            pending_callbacks = {};
+        }
+
+        if (free_command_buffers.empty()) {
+            batch.command_buffer = CommandBuffer::allocate(context, command_pool);
+        } else {
+            batch.command_buffer = free_command_buffers.back();
+            free_command_buffers.pop_back();
+        }
+
+        batch.command_buffer.begin();
+        for (const auto& each : copies) {
+            vkCmdCopyBuffer(batch.command_buffer.handle(), each.source, each.dest, 1, &each.region);
+        }
+        record_images(batch.command_buffer.handle(), images);
+        batch.command_buffer.end();
+        batch.value = ++timeline_value;
+
+        VkTimelineSemaphoreSubmitInfo timeline_submit_info{};
+        timeline_submit_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timeline_submit_info.signalSemaphoreValueCount = 1;
+        timeline_submit_info.pSignalSemaphoreValues = &batch.value;
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.pNext = &timeline_submit_info;
+        submit_info.waitSemaphoreCount = 0;
+        submit_info.pWaitSemaphores = nullptr;
+        submit_info.pWaitDstStageMask = nullptr;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = batch.command_buffer.ptr_handle();
+        submit_info.signalSemaphoreCount = 1;
+        submit_info.pSignalSemaphores = &timeline;
+        {
+            // The queue mutex is only held for the submission itself, completion is tracked by the timeline.
+            std::lock_guard<std::mutex> lock(task::get_transfer_mutex());
+            qz_vulkan_check(vkQueueSubmit(context.transfer, 1, &submit_info, nullptr));
+        }
+        in_flight.emplace_back(std::move(batch));
+        return timeline_value;
+    }
+
+    void poll_uploads(const Context& context) noexcept {
+        std::vector<std::function<void()>> callbacks;
+        {
+            std::lock_guard<std::mutex> batch_lock(batch_mutex);
+            if (!in_flight.empty()) {
+                std::uint64_t completed;
+                qz_vulkan_check(vkGetSemaphoreCounterValue(context.device, timeline, &completed));
+                while (!in_flight.empty() && in_flight.front().value <= completed) {
+                    auto& batch = in_flight.front();
+                    for (auto& each : batch.dedicated) {
+                        Buffer::destroy(context, each);
+                    }
+                    std::move(batch.callbacks.begin(), batch.callbacks.end(), std::back_inserter(callbacks));
+                    free_command_buffers.emplace_back(batch.command_buffer);
+                    in_flight.pop_front();
+                }
+            }
+            reclaim_staging();
+        }
+
+        for (auto& callback : callbacks) {
+            callback();
+        }
+    }
+
+    qz_nodiscard StagingRing::Statistics staging_statistics() noexcept {
+        return staging.statistics();
+    }
+
+    void drain_loader_tasks(const Context& context) noexcept {
+        while (task::pending_loader_tasks() != 0) {
+            poll_uploads(context);
+            task::poll_timelines(context);
+            (void)flush_uploads(context);
+            std::this_thread::yield();
+        }
+    }
+
+    void destroy_uploads(const Context& context) noexcept {
+        (void)flush_uploads(context);
+
+        VkSemaphoreWaitInfo wait_info{};
+        wait_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        wait_info.semaphoreCount = 1;
+        wait_info.pSemaphores = &timeline;
+        wait_info.pValues = &timeline_value;
+        qz_vulkan_check(vkWaitSemaphores(context.device, &wait_info, -1));
+        poll_uploads(context);
+
+        vkDestroySemaphore(context.device, timeline, nullptr);
+        vkDestroyCommandPool(context.device, command_pool, nullptr);
+        free_command_buffers = {};
+        StagingRing::destroy(context, staging);
+    }
+} // namespace qz::gfx
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <qz/gfx/buffer.hpp>
+#include <qz/gfx/image.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <cstdint>
+#include <span>
+
+namespace qz::gfx {
+    struct BufferUpload {
+        const void* data;
+        std::size_t size;
+        VkBuffer dest;
+        std::size_t offset;
+    };
+
+    // One tightly packed mip level, levels are given in order starting from mip 0.
+    struct ImageUpload {
+        const void* data;
+        std::size_t size;
+    };
+
+    void initialize_uploads(const Context&) noexcept;
+
+    // Copies the data into staging memory and queues the copies for the next flush, parks the calling task
+    // if the staging ring is full. The callback is invoked by whoever retires the batch once the GPU is done with it.
+    void upload_buffers(const Context&, std::span<const BufferUpload>, std::function<void()>&&) noexcept;
+
+    // Copies the given levels into the image, generating the remaining ones by blitting each level down from the
+    // previous one. The image ends up in SHADER_READ_ONLY_OPTIMAL layout by the time the callback is invoked.
+    void upload_image(const Context&, const Image&, std::span<const ImageUpload>, std::function<void()>&&) noexcept;
+
+    // Records every pending copy into one command buffer and submits it with a single vkQueueSubmit.
+    // Returns the timeline value the batch signals, or the last submitted one if nothing was pending.
+    std::uint64_t flush_uploads(const Context&) noexcept;
+
+    // Retires every batch the GPU has finished, releasing staging memory and running completion callbacks.
+    void poll_uploads(const Context&) noexcept;
+
+    // Occupancy, allocation and stall counters of the shared staging ring.
+    qz_nodiscard StagingRing::Statistics staging_statistics() noexcept;
+    // Pumps uploads and parked tasks on the render thread until every loader task returned. Called before
+    // uploads, streaming or assets are destroyed, as those tasks may still be staging data or reading files.
+    void drain_loader_tasks(const Context&) noexcept;
+    void destroy_uploads(const Context&) noexcept;
+} // namespace qz::gfx
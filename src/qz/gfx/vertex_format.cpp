@@ -0,0 +1,218 @@
+#include <qz/gfx/vertex_format.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define QUARTZ_SSE2
+    #include <emmintrin.h>
+#endif
+
+namespace qz::gfx {
+    qz_nodiscard std::uint32_t attribute_size(const VertexAttribute attribute) noexcept {
+        switch (attribute) {
+            case VertexAttribute::vec1: return sizeof(float[1]);
+            case VertexAttribute::vec2: return sizeof(float[2]);
+            case VertexAttribute::vec3: return sizeof(float[3]);
+            case VertexAttribute::vec4: return sizeof(float[4]);
+            case VertexAttribute::half2: return sizeof(std::uint16_t[2]);
+            case VertexAttribute::half4: return sizeof(std::uint16_t[4]);
+            case VertexAttribute::snorm8x4:
+            case VertexAttribute::unorm8x4:
+            case VertexAttribute::a2b10g10r10: return sizeof(std::uint32_t);
+        }
+        qz_unreachable();
+    }
+
+    qz_nodiscard std::uint32_t attribute_components(const VertexAttribute attribute) noexcept {
+        switch (attribute) {
+            case VertexAttribute::vec1: return 1;
+            case VertexAttribute::vec2:
+            case VertexAttribute::half2: return 2;
+            case VertexAttribute::vec3: return 3;
+            case VertexAttribute::vec4:
+            case VertexAttribute::half4:
+            case VertexAttribute::snorm8x4:
+            case VertexAttribute::unorm8x4:
+            case VertexAttribute::a2b10g10r10: return 4;
+        }
+        qz_unreachable();
+    }
+
+    qz_nodiscard std::uint32_t vertex_stride(const std::vector<VertexAttribute>& attributes) noexcept {
+        return std::accumulate(attributes.begin(), attributes.end(), 0u, [](const auto value, const auto attribute) {
+            return value + attribute_size(attribute);
+        });
+    }
+
+    qz_nodiscard std::uint32_t vertex_components(const std::vector<VertexAttribute>& attributes) noexcept {
+        return std::accumulate(attributes.begin(), attributes.end(), 0u, [](const auto value, const auto attribute) {
+            return value + attribute_components(attribute);
+        });
+    }
+
+#if defined(QUARTZ_SSE2)
+    // Round to nearest even float to half conversion of four lanes, results are in the low 16 bits of each lane.
+    qz_nodiscard static __m128i float_to_half(const __m128 value) noexcept {
+        const auto infinity = _mm_set1_epi32(255 << 23);
+        const auto half_max = _mm_set1_epi32((127 + 16) << 23);
+        const auto denormal_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+        const auto select = [](const __m128i mask, const __m128i lhs, const __m128i rhs) noexcept {
+            return _mm_or_si128(_mm_and_si128(mask, lhs), _mm_andnot_si128(mask, rhs));
+        };
+
+        auto bits = _mm_castps_si128(value);
+        const auto sign = _mm_and_si128(bits, _mm_set1_epi32(static_cast<int>(0x80000000)));
+        bits = _mm_xor_si128(bits, sign);
+
+        // Overflows become infinity, NaNs stay quiet NaNs.
+        const auto overflow = _mm_cmpgt_epi32(bits, _mm_sub_epi32(half_max, _mm_set1_epi32(1)));
+        const auto nan = _mm_cmpgt_epi32(bits, infinity);
+        const auto special = select(nan, _mm_set1_epi32(0x7e00), _mm_set1_epi32(0x7c00));
+
+        // Denormals are rounded by the FPU when adding the magic number.
+        const auto is_denormal = _mm_cmpgt_epi32(_mm_set1_epi32(113 << 23), bits);
+        const auto denormal = _mm_sub_epi32(
+            _mm_castps_si128(_mm_add_ps(_mm_castsi128_ps(bits), _mm_castsi128_ps(denormal_magic))), denormal_magic);
+
+        const auto odd = _mm_and_si128(_mm_srli_epi32(bits, 13), _mm_set1_epi32(1));
+        auto normal = _mm_add_epi32(bits, _mm_set1_epi32(((15 - 127) << 23) + 0xfff));
+        normal = _mm_srli_epi32(_mm_add_epi32(normal, odd), 13);
+
+        auto result = select(is_denormal, denormal, normal);
+        result = select(overflow, special, result);
+        return _mm_or_si128(result, _mm_srli_epi32(sign, 16));
+    }
+
+    static void pack_attribute(const float* source, const VertexAttribute attribute, char* dest) noexcept {
+        alignas(16) float padded[4] = {};
+        std::memcpy(padded, source, attribute_components(attribute) * sizeof(float));
+        const auto value = _mm_load_ps(padded);
+        switch (attribute) {
+            case VertexAttribute::half2:
+            case VertexAttribute::half4: {
+                // Sign extend so the saturating pack keeps the bits as they are.
+                auto halves = _mm_srai_epi32(_mm_slli_epi32(float_to_half(value), 16), 16);
+                halves = _mm_packs_epi32(halves, halves);
+                alignas(16) std::uint16_t result[8];
+                _mm_store_si128(reinterpret_cast<__m128i*>(result), halves);
+                std::memcpy(dest, result, attribute_size(attribute));
+                break;
+            }
+            case VertexAttribute::snorm8x4: {
+                const auto clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+                auto result = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(127.0f)));
+                result = _mm_packs_epi32(result, result);
+                result = _mm_packs_epi16(result, result);
+                const auto packed = _mm_cvtsi128_si32(result);
+                std::memcpy(dest, &packed, sizeof packed);
+                break;
+            }
+            case VertexAttribute::unorm8x4: {
+                const auto clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                auto result = _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(255.0f)));
+                result = _mm_packs_epi32(result, result);
+                result = _mm_packus_epi16(result, result);
+                const auto packed = _mm_cvtsi128_si32(result);
+                std::memcpy(dest, &packed, sizeof packed);
+                break;
+            }
+            case VertexAttribute::a2b10g10r10: {
+                const auto clamped = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+                alignas(16) std::uint32_t lanes[4];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes),
+                    _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_setr_ps(1023.0f, 1023.0f, 1023.0f, 3.0f))));
+                const auto packed = lanes[0] | (lanes[1] << 10) | (lanes[2] << 20) | (lanes[3] << 30);
+                std::memcpy(dest, &packed, sizeof packed);
+                break;
+            }
+            default:
+                std::memcpy(dest, source, attribute_size(attribute));
+                break;
+        }
+    }
+#else
+    qz_nodiscard static std::uint16_t float_to_half(const float value) noexcept {
+        std::uint32_t bits;
+        std::memcpy(&bits, &value, sizeof bits);
+        const auto sign = bits & 0x80000000u;
+        bits ^= sign;
+
+        std::uint32_t result;
+        if (bits >= (127u + 16u) << 23) {
+            result = bits > 255u << 23 ? 0x7e00 : 0x7c00;
+        } else if (bits < 113u << 23) {
+            constexpr auto magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+            float denormal, magic_float;
+            std::memcpy(&denormal, &bits, sizeof bits);
+            std::memcpy(&magic_float, &magic, sizeof magic);
+            denormal += magic_float;
+            std::memcpy(&result, &denormal, sizeof result);
+            result -= magic;
+        } else {
+            result = (bits + ((15u - 127u) << 23) + 0xfff + ((bits >> 13) & 1)) >> 13;
+        }
+        return static_cast<std::uint16_t>(result | (sign >> 16));
+    }
+
+    static void pack_attribute(const float* source, const VertexAttribute attribute, char* dest) noexcept {
+        const auto components = attribute_components(attribute);
+        switch (attribute) {
+            case VertexAttribute::half2:
+            case VertexAttribute::half4: {
+                std::uint16_t result[4];
+                for (std::uint32_t i = 0; i < components; ++i) {
+                    result[i] = float_to_half(source[i]);
+                }
+                std::memcpy(dest, result, attribute_size(attribute));
+                break;
+            }
+            case VertexAttribute::snorm8x4: {
+                for (std::uint32_t i = 0; i < components; ++i) {
+                    const auto result = static_cast<std::int8_t>(std::lrint(std::clamp(source[i], -1.0f, 1.0f) * 127.0f));
+                    std::memcpy(dest + i, &result, sizeof result);
+                }
+                break;
+            }
+            case VertexAttribute::unorm8x4: {
+                for (std::uint32_t i = 0; i < components; ++i) {
+                    dest[i] = static_cast<char>(std::lrint(std::clamp(source[i], 0.0f, 1.0f) * 255.0f));
+                }
+                break;
+            }
+            case VertexAttribute::a2b10g10r10: {
+                const auto scale = [source](const std::uint32_t index, const float max) noexcept {
+                    return static_cast<std::uint32_t>(std::lrint(std::clamp(source[index], 0.0f, 1.0f) * max));
+                };
+                const auto packed = scale(0, 1023.0f) | (scale(1, 1023.0f) << 10) | (scale(2, 1023.0f) << 20) | (scale(3, 3.0f) << 30);
+                std::memcpy(dest, &packed, sizeof packed);
+                break;
+            }
+            default:
+                std::memcpy(dest, source, attribute_size(attribute));
+                break;
+        }
+    }
+#endif
+
+    void pack_vertices(const std::span<const float> vertices, const std::vector<VertexAttribute>& attributes, void* dest) noexcept {
+        const auto components = vertex_components(attributes);
+        const auto stride = vertex_stride(attributes);
+        if (vertices.size() % components != 0) {
+            qz_force_assert("Vertex data doesn't match the attributes");
+        }
+
+        auto output = static_cast<char*>(dest);
+        for (std::size_t vertex = 0; vertex < vertices.size(); vertex += components, output += stride) {
+            const auto* source = vertices.data() + vertex;
+            auto* current = output;
+            for (const auto each : attributes) {
+                pack_attribute(source, each, current);
+                source += attribute_components(each);
+                current += attribute_size(each);
+            }
+        }
+    }
+} // namespace qz::gfx
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+#include <vector>
+#include <span>
+
+namespace qz::gfx {
+    // Values are stored in .qzm files, new kinds must be appended.
+    enum class VertexAttribute : std::uint32_t {
+        vec1,
+        vec2,
+        vec3,
+        vec4,
+        half2,
+        half4,
+        snorm8x4,
+        unorm8x4,
+        // Unsigned normalized, 10 bits for xyz and 2 for w.
+        a2b10g10r10
+    };
+    // Values read from files are checked against it, must follow the last kind.
+    constexpr auto vertex_attribute_count = static_cast<std::uint32_t>(VertexAttribute::a2b10g10r10) + 1;
+
+    // Size in bytes of the attribute on the GPU.
+    qz_nodiscard std::uint32_t attribute_size(VertexAttribute) noexcept;
+    // Number of floats the attribute is built from before packing.
+    qz_nodiscard std::uint32_t attribute_components(VertexAttribute) noexcept;
+
+    qz_nodiscard std::uint32_t vertex_stride(const std::vector<VertexAttribute>&) noexcept;
+    qz_nodiscard std::uint32_t vertex_components(const std::vector<VertexAttribute>&) noexcept;
+
+    // Converts vertices given as attribute_components() floats per attribute into the packed layout described
+    // by the attributes. The destination must hold vertex_stride() bytes per vertex.
+    void pack_vertices(std::span<const float>, const std::vector<VertexAttribute>&, void*) noexcept;
+} // namespace qz::gfx
\ No newline at end of file
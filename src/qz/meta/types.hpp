@@ -3,14 +3,17 @@
 #include <qz/meta/constants.hpp>
 
 #include <cstdlib>
+#include <cstdint>
 #include <array>
 
 namespace qz::meta {
     template <typename T>
     using in_flight_array = std::array<T, in_flight>;
 
+    // Generation tagged index into the asset table, a handle outlived by its slot's reuse is rejected.
     template <typename T>
     struct Handle {
-        std::size_t index;
+        std::uint32_t index;
+        std::uint32_t generation;
     };
 } // namespace qz::meta
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include <qz/task/completion.hpp>
+#include <qz/task/scheduler.hpp>
+#include <qz/gfx/context.hpp>
+
+#include <ftl/wait_group.h>
+
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <mutex>
+
+namespace qz::task {
+    struct TimelineWaiter {
+        VkSemaphore semaphore;
+        std::uint64_t value;
+        ftl::WaitGroup* wait_group;
+    };
+
+    static std::vector<TimelineWaiter> waiters;
+    static std::mutex waiters_mutex;
+    static std::atomic<std::uint32_t> loader_tasks;
+
+    void wait_timeline(const gfx::Context& context, VkSemaphore semaphore, const std::uint64_t value) noexcept {
+        std::uint64_t current;
+        qz_vulkan_check(vkGetSemaphoreCounterValue(context.device, semaphore, &current));
+        if (current >= value) {
+            return;
+        }
+
+        ftl::WaitGroup wait_group(&get_scheduler());
+        wait_group.Add(1);
+        {
+            std::lock_guard<std::mutex> lock(waiters_mutex);
+            waiters.push_back({ semaphore, value, &wait_group });
+        }
+        wait_group.Wait();
+    }
+
+    void poll_timelines(const gfx::Context& context) noexcept {
+        std::lock_guard<std::mutex> lock(waiters_mutex);
+        if (waiters.empty()) {
+            return;
+        }
+
+        // Waiters are sorted by semaphore so each counter is only queried once.
+        std::sort(waiters.begin(), waiters.end(), [](const auto& lhs, const auto& rhs) noexcept {
+            return lhs.semaphore < rhs.semaphore;
+        });
+
+        VkSemaphore semaphore = nullptr;
+        std::uint64_t current = 0;
+        std::erase_if(waiters, [&](const TimelineWaiter& waiter) noexcept {
+            if (waiter.semaphore != semaphore) {
+                semaphore = waiter.semaphore;
+                qz_vulkan_check(vkGetSemaphoreCounterValue(context.device, semaphore, &current));
+            }
+            if (current >= waiter.value) {
+                waiter.wait_group->Done();
+                return true;
+            }
+            return false;
+        });
+    }
+
+    void begin_loader_task() noexcept {
+        loader_tasks.fetch_add(1);
+    }
+
+    void end_loader_task() noexcept {
+        loader_tasks.fetch_sub(1);
+    }
+
+    qz_nodiscard std::uint32_t pending_loader_tasks() noexcept {
+        return loader_tasks.load();
+    }
+} // namespace qz::task
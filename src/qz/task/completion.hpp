@@ -0,0 +1,22 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace qz::task {
+    // Parks the calling task on a WaitGroup until the timeline semaphore reaches the given value,
+    // the worker thread is free to run other tasks in the meantime.
+    void wait_timeline(const gfx::Context&, VkSemaphore, std::uint64_t) noexcept;
+
+    // Resumes every parked task whose timeline value has been reached, must be called from a scheduler thread.
+    void poll_timelines(const gfx::Context&) noexcept;
+
+    // Loader tasks are counted from when they are queued until they return, so teardown can wait for them.
+    void begin_loader_task() noexcept;
+    void end_loader_task() noexcept;
+    qz_nodiscard std::uint32_t pending_loader_tasks() noexcept;
+} // namespace qz::task
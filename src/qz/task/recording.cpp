@@ -0,0 +1,73 @@
+#include <qz/gfx/command_buffer.hpp>
+#include <qz/task/recording.hpp>
+#include <qz/task/scheduler.hpp>
+#include <qz/gfx/render_pass.hpp>
+
+#include <ftl/wait_group.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace qz::task {
+    struct RecordTask {
+        const gfx::Context* context;
+        const gfx::RenderPass* render_pass;
+        const RecordFunction* function;
+        gfx::CommandBuffer* result;
+        std::size_t framebuffer;
+        std::uint32_t frame;
+        std::size_t begin;
+        std::size_t end;
+    };
+
+    void record_parallel(const gfx::Context& context,
+                         gfx::CommandBuffer& primary,
+                         const gfx::RenderPass& render_pass,
+                         const std::size_t framebuffer,
+                         const std::uint32_t frame,
+                         const std::size_t draws,
+                         const std::size_t chunk_size,
+                         const RecordFunction& function) noexcept {
+        if (chunk_size == 0) {
+            qz_force_assert("Recording chunk size must not be zero");
+        }
+        if (draws == 0) {
+            return;
+        }
+
+        const auto chunks = (draws + chunk_size - 1) / chunk_size;
+        std::vector<gfx::CommandBuffer> recorded(chunks);
+        std::vector<RecordTask> task_data(chunks);
+        std::vector<ftl::Task> tasks(chunks);
+        for (std::size_t i = 0; i < chunks; ++i) {
+            task_data[i] = {
+                &context,
+                &render_pass,
+                &function,
+                &recorded[i],
+                framebuffer,
+                frame,
+                i * chunk_size,
+                std::min(draws, (i + 1) * chunk_size)
+            };
+            tasks[i] = {
+                .Function = +[](ftl::TaskScheduler*, void* ptr) {
+                    const auto data = static_cast<RecordTask*>(ptr);
+                    // Recording never yields, the task stays on this thread and is the only user of its pool.
+                    auto command_buffer = acquire_command_buffer(*data->context, data->frame, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+                    command_buffer.begin_secondary(*data->render_pass, data->framebuffer);
+                    (*data->function)(command_buffer, data->begin, data->end);
+                    command_buffer.end();
+                    *data->result = command_buffer;
+                },
+                .ArgData = &task_data[i]
+            };
+        }
+
+        ftl::WaitGroup wait_group(&get_scheduler());
+        get_scheduler().AddTasks(tasks.size(), tasks.data(), ftl::TaskPriority::High, &wait_group);
+        // The caller owns the primary and the window, it must resume on the same thread.
+        wait_group.Wait(true);
+        primary.execute_commands(recorded);
+    }
+} // namespace qz::task
\ No newline at end of file
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+#include <qz/util/fwd.hpp>
+
+#include <functional>
+#include <cstdint>
+
+namespace qz::task {
+    // Records the draws in [begin, end) into a secondary command buffer that already continues the render pass.
+    using RecordFunction = std::function<void(gfx::CommandBuffer&, std::size_t, std::size_t)>;
+
+    // Splits a draw list into chunks, every worker records its chunks into secondary command buffers taken from
+    // its own pool for the given frame in flight, and the primary executes them in draw order. The primary must be
+    // inside a render pass begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS.
+    void record_parallel(const gfx::Context&, gfx::CommandBuffer&, const gfx::RenderPass&, std::size_t, std::uint32_t, std::size_t, std::size_t, const RecordFunction&) noexcept;
+} // namespace qz::task
\ No newline at end of file
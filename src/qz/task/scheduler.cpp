@@ -1,8 +1,20 @@
 #include <qz/task/scheduler.hpp>
 #include <qz/gfx/context.hpp>
+#include <qz/meta/types.hpp>
+
+#include <vector>
 
 namespace qz::task {
-    static std::vector<VkCommandPool> command_pools;
+    // Transient pool owned by one thread for one frame in flight, command buffers are recycled instead of freed.
+    struct FramePool {
+        VkCommandPool handle;
+        std::vector<gfx::CommandBuffer> primary;
+        std::vector<gfx::CommandBuffer> secondary;
+        std::size_t used_primary;
+        std::size_t used_secondary;
+    };
+
+    static std::vector<meta::in_flight_array<FramePool>> frame_pools;
     static ftl::TaskScheduler scheduler;
     static std::mutex transfer_mutex;
 
@@ -11,13 +23,16 @@ namespace qz::task {
             .Behavior = ftl::EmptyQueueBehavior::Sleep
         });
 
+        // No individual reset flag, the whole pool is reset once per frame.
         VkCommandPoolCreateInfo command_pool_create_info{};
         command_pool_create_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        command_pool_create_info.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
         command_pool_create_info.queueFamilyIndex = context.family;
-        command_pools.reserve(scheduler.GetThreadCount());
-        for (std::size_t i = 0; i < scheduler.GetThreadCount(); ++i) {
-            qz_vulkan_check(vkCreateCommandPool(context.device, &command_pool_create_info, nullptr, &command_pools.emplace_back()));
+        frame_pools.resize(scheduler.GetThreadCount());
+        for (auto& thread : frame_pools) {
+            for (auto& each : thread) {
+                qz_vulkan_check(vkCreateCommandPool(context.device, &command_pool_create_info, nullptr, &each.handle));
+            }
         }
     }
 
@@ -25,8 +40,27 @@ namespace qz::task {
         return scheduler;
     }
 
-    qz_nodiscard VkCommandPool get_command_pool(const std::size_t index) noexcept {
-        return command_pools[index];
+    qz_nodiscard gfx::CommandBuffer acquire_command_buffer(const gfx::Context& context, const std::uint32_t frame, const VkCommandBufferLevel level) noexcept {
+        auto& pool = frame_pools[scheduler.GetCurrentThreadIndex()][frame];
+        const auto is_primary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        auto& command_buffers = is_primary ? pool.primary : pool.secondary;
+        auto& used = is_primary ? pool.used_primary : pool.used_secondary;
+        if (used == command_buffers.size()) {
+            command_buffers.emplace_back(gfx::CommandBuffer::allocate(context, pool.handle, level));
+        }
+        return command_buffers[used++];
+    }
+
+    void reset_command_pools(const gfx::Context& context, const std::uint32_t frame) noexcept {
+        for (auto& thread : frame_pools) {
+            auto& pool = thread[frame];
+            if (pool.used_primary + pool.used_secondary == 0) {
+                continue;
+            }
+            qz_vulkan_check(vkResetCommandPool(context.device, pool.handle, 0));
+            pool.used_primary = 0;
+            pool.used_secondary = 0;
+        }
     }
 
     qz_nodiscard std::mutex& get_transfer_mutex() noexcept {
@@ -34,8 +68,11 @@ namespace qz::task {
     }
 
     void destroy_scheduler(const gfx::Context& context) noexcept {
-        for (const auto& each : command_pools) {
-            vkDestroyCommandPool(context.device, each, nullptr);
+        for (const auto& thread : frame_pools) {
+            for (const auto& each : thread) {
+                vkDestroyCommandPool(context.device, each.handle, nullptr);
+            }
         }
+        frame_pools = {};
     }
 } // namespace qz::task
\ No newline at end of file
@@ -3,13 +3,23 @@
 #include <qz/util/macros.hpp>
 #include <qz/util/fwd.hpp>
 
+#include <qz/gfx/command_buffer.hpp>
+
 #include <ftl/task_scheduler.h>
 #include <vulkan/vulkan.h>
 
 namespace qz::task {
     void initialize_scheduler(const gfx::Context&) noexcept;
     qz_nodiscard ftl::TaskScheduler& get_scheduler() noexcept;
-    qz_nodiscard VkCommandPool get_command_pool(std::size_t) noexcept;
+
+    // Hands out a command buffer from the calling thread's pool for the given frame in flight. The buffer is only valid
+    // until that frame's pools are reset, the calling task must not yield until it's done recording.
+    qz_nodiscard gfx::CommandBuffer acquire_command_buffer(const gfx::Context&, std::uint32_t, VkCommandBufferLevel) noexcept;
+
+    // Resets every thread's pool for the given frame in flight with a single vkResetCommandPool each,
+    // must only be called once the frame's fence has signaled.
+    void reset_command_pools(const gfx::Context&, std::uint32_t) noexcept;
+
     qz_nodiscard std::mutex& get_transfer_mutex() noexcept;
     void destroy_scheduler(const gfx::Context&) noexcept;
 } // namespace qz::task
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include <qz/util/free_list.hpp>
+
+namespace qz::util {
+    FreeList::FreeList(const std::size_t capacity) noexcept : _capacity(capacity) {
+        insert(0, capacity);
+    }
+
+    void FreeList::insert(const std::size_t offset, const std::size_t size) noexcept {
+        _by_offset.emplace(offset, size);
+        _by_size.emplace(size, offset);
+    }
+
+    void FreeList::erase(const std::map<std::size_t, std::size_t>::iterator range) noexcept {
+        auto [first, last] = _by_size.equal_range(range->second);
+        for (; first != last; ++first) {
+            if (first->second == range->first) {
+                _by_size.erase(first);
+                break;
+            }
+        }
+        _by_offset.erase(range);
+    }
+
+    qz_nodiscard std::optional<std::size_t> FreeList::allocate(const std::size_t size, const std::size_t alignment) noexcept {
+        if (alignment == 0) {
+            qz_force_assert("Free list alignment must not be zero");
+        }
+        // Smallest free range that still fits the request once aligned.
+        for (auto candidate = _by_size.lower_bound(size); candidate != _by_size.end(); ++candidate) {
+            const auto [range_size, range_offset] = *candidate;
+            const auto padding = (alignment - range_offset % alignment) % alignment;
+            if (range_size < size + padding) {
+                continue;
+            }
+
+            erase(_by_offset.find(range_offset));
+            if (padding != 0) {
+                insert(range_offset, padding);
+            }
+            if (range_size > size + padding) {
+                insert(range_offset + padding + size, range_size - size - padding);
+            }
+            _used += size;
+            return range_offset + padding;
+        }
+        return std::nullopt;
+    }
+
+    void FreeList::free(std::size_t offset, std::size_t size) noexcept {
+        qz_assert(offset + size <= _capacity, "Range not owned by this free list");
+        _used -= size;
+
+        // Merge with the neighbouring free ranges.
+        auto next = _by_offset.lower_bound(offset);
+        if (next != _by_offset.end() && offset + size == next->first) {
+            size += next->second;
+            erase(next);
+        }
+        auto previous = _by_offset.lower_bound(offset);
+        if (previous != _by_offset.begin()) {
+            --previous;
+            if (previous->first + previous->second == offset) {
+                offset = previous->first;
+                size += previous->second;
+                erase(previous);
+            }
+        }
+        insert(offset, size);
+    }
+
+    qz_nodiscard std::size_t FreeList::capacity() const noexcept {
+        return _capacity;
+    }
+
+    qz_nodiscard std::size_t FreeList::used() const noexcept {
+        return _used;
+    }
+} // namespace qz::util
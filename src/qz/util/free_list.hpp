@@ -0,0 +1,30 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+
+#include <optional>
+#include <cstdint>
+#include <map>
+
+namespace qz::util {
+    // Best-fit range allocator over an abstract address space, free ranges are coalesced on release.
+    class FreeList {
+        std::map<std::size_t, std::size_t> _by_offset;
+        std::multimap<std::size_t, std::size_t> _by_size;
+        std::size_t _capacity = 0;
+        std::size_t _used = 0;
+
+        void insert(std::size_t, std::size_t) noexcept;
+        void erase(std::map<std::size_t, std::size_t>::iterator) noexcept;
+    public:
+        FreeList() noexcept = default;
+        explicit FreeList(std::size_t) noexcept;
+
+        // Alignment does not need to be a power of two, vertex strides are used as alignments too.
+        qz_nodiscard std::optional<std::size_t> allocate(std::size_t, std::size_t) noexcept;
+        void free(std::size_t, std::size_t) noexcept;
+
+        qz_nodiscard std::size_t capacity() const noexcept;
+        qz_nodiscard std::size_t used() const noexcept;
+    };
+} // namespace qz::util
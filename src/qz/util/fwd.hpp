@@ -9,6 +9,8 @@ namespace qz::gfx {
     struct Image;
     struct Swapchain;
     class RenderPass;
+    struct RenderGraph;
+    struct FrameInfo;
     struct Pipeline;
     class CommandBuffer;
     struct Buffer;
@@ -0,0 +1,72 @@
+#include <qz/util/mapped_file.hpp>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+    #include <fcntl.h>
+#endif
+
+namespace qz::util {
+    qz_nodiscard MappedFile MappedFile::create(const char* path) noexcept {
+        MappedFile file{};
+#if defined(_WIN32)
+        const auto handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle == INVALID_HANDLE_VALUE) {
+            qz_force_assert("Failed to open file");
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(handle, &size)) {
+            qz_force_assert("Failed to query file size");
+        }
+        file.size = size.QuadPart;
+        if (file.size == 0) {
+            qz_force_assert("Cannot map an empty file");
+        }
+
+        // The view keeps the mapping alive, neither handle is needed after this.
+        const auto mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping == nullptr) {
+            qz_force_assert("Failed to map file");
+        }
+        file.data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (file.data == nullptr) {
+            qz_force_assert("Failed to map file");
+        }
+        CloseHandle(mapping);
+        CloseHandle(handle);
+#else
+        const auto descriptor = open(path, O_RDONLY);
+        if (descriptor == -1) {
+            qz_force_assert("Failed to open file");
+        }
+        struct stat status;
+        if (fstat(descriptor, &status) != 0) {
+            qz_force_assert("Failed to query file size");
+        }
+        file.size = status.st_size;
+        if (file.size == 0) {
+            qz_force_assert("Cannot map an empty file");
+        }
+
+        // The mapping outlives the descriptor.
+        file.data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (file.data == MAP_FAILED) {
+            qz_force_assert("Failed to map file");
+        }
+        close(descriptor);
+#endif
+        return file;
+    }
+
+    void MappedFile::destroy(MappedFile& file) noexcept {
+#if defined(_WIN32)
+        UnmapViewOfFile(file.data);
+#else
+        munmap(const_cast<void*>(file.data), file.size);
+#endif
+        file = {};
+    }
+} // namespace qz::util
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <qz/util/macros.hpp>
+
+#include <cstdint>
+
+namespace qz::util {
+    // Read-only view of a whole file, the mapping is page aligned.
+    struct MappedFile {
+        const void* data;
+        std::size_t size;
+
+        qz_nodiscard static MappedFile create(const char*) noexcept;
+        static void destroy(MappedFile&) noexcept;
+    };
+} // namespace qz::util
\ No newline at end of file
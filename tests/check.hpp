@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdio>
+
+// Shared by the tests: every failed check is reported and counted, main returns non-zero if any failed.
+
+inline int failures = 0;
+
+inline void check(const bool condition, const char* test, const char* message) noexcept {
+    if (!condition) {
+        std::fprintf(stderr, "%s: %s\n", test, message);
+        ++failures;
+    }
+}
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include <qz/gfx/mesh_optimizer.hpp>
+
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+#include <array>
+#include <cmath>
+
+// Runs the whole optimization pipeline on a few meshes and checks it only reorders them: the triangles drawn
+// afterwards, each compared by the values of its vertices, must be the same multiset as before.
+
+struct Mesh {
+    const char* name;
+    std::vector<float> vertices;
+    std::vector<std::uint32_t> indices;
+};
+
+using Triangle = std::vector<float>;
+
+// Triangles with their vertex values inlined, rotated to start at the smallest vertex so winding is kept.
+static std::vector<Triangle> triangle_set(const std::vector<float>& vertices, const std::vector<std::uint32_t>& indices) noexcept {
+    std::vector<Triangle> triangles;
+    for (std::size_t i = 0; i < indices.size(); i += 3) {
+        std::array<std::vector<float>, 3> corners;
+        for (std::size_t j = 0; j < 3; ++j) {
+            const auto first = vertices.begin() + indices[i + j] * 7;
+            corners[j].assign(first, first + 7);
+        }
+        const auto start = std::min_element(corners.begin(), corners.end()) - corners.begin();
+        Triangle triangle;
+        for (std::size_t j = 0; j < 3; ++j) {
+            const auto& corner = corners[(start + j) % 3];
+            triangle.insert(triangle.end(), corner.begin(), corner.end());
+        }
+        triangles.emplace_back(std::move(triangle));
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void push_vertex(Mesh& mesh, const float x, const float y, const float z) noexcept {
+    mesh.vertices.insert(mesh.vertices.end(), { x, y, z, x * 0.5f + 0.5f, y * 0.5f + 0.5f, z * 0.5f + 0.5f, 1.0f });
+}
+
+static Mesh make_grid(const std::uint32_t size) noexcept {
+    Mesh mesh{ "grid", {}, {} };
+    for (std::uint32_t y = 0; y < size; ++y) {
+        for (std::uint32_t x = 0; x < size; ++x) {
+            push_vertex(mesh, static_cast<float>(x) / (size - 1), static_cast<float>(y) / (size - 1), 0.0f);
+        }
+    }
+    for (std::uint32_t y = 0; y + 1 < size; ++y) {
+        for (std::uint32_t x = 0; x + 1 < size; ++x) {
+            const auto corner = y * size + x;
+            mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, corner + size, corner + 1, corner + size + 1, corner + size });
+        }
+    }
+    return mesh;
+}
+
+// Same grid with every triangle given its own vertices, deduplication has to merge them back.
+static Mesh make_unshared_grid(const std::uint32_t size) noexcept {
+    const auto grid = make_grid(size);
+    Mesh mesh{ "unshared grid", {}, {} };
+    for (const auto index : grid.indices) {
+        mesh.indices.emplace_back(mesh.vertices.size() / 7);
+        mesh.vertices.insert(mesh.vertices.end(), grid.vertices.begin() + index * 7, grid.vertices.begin() + index * 7 + 7);
+    }
+    return mesh;
+}
+
+// Triangles shuffled with a fixed seed, the worst case for the vertex cache.
+static Mesh make_shuffled_grid(const std::uint32_t size) noexcept {
+    auto mesh = make_grid(size);
+    mesh.name = "shuffled grid";
+    std::uint32_t state = 12345;
+    for (auto i = mesh.indices.size() / 3 - 1; i > 0; --i) {
+        state = state * 1664525u + 1013904223u;
+        const auto j = state % (i + 1);
+        std::swap_ranges(mesh.indices.begin() + i * 3, mesh.indices.begin() + i * 3 + 3, mesh.indices.begin() + j * 3);
+    }
+    return mesh;
+}
+
+// Closed mesh facing every direction, so overdraw ordering has clusters to sort.
+static Mesh make_sphere(const std::uint32_t rings, const std::uint32_t segments) noexcept {
+    Mesh mesh{ "sphere", {}, {} };
+    for (std::uint32_t ring = 0; ring <= rings; ++ring) {
+        const auto theta = 3.14159265f * ring / rings;
+        for (std::uint32_t segment = 0; segment <= segments; ++segment) {
+            const auto phi = 2.0f * 3.14159265f * segment / segments;
+            push_vertex(mesh, std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+        }
+    }
+    for (std::uint32_t ring = 0; ring < rings; ++ring) {
+        for (std::uint32_t segment = 0; segment < segments; ++segment) {
+            const auto corner = ring * (segments + 1) + segment;
+            const auto below = corner + segments + 1;
+            mesh.indices.insert(mesh.indices.end(), { corner, below, corner + 1, corner + 1, below, below + 1 });
+        }
+    }
+    return mesh;
+}
+
+static void test_mesh(Mesh mesh) noexcept {
+    const auto before = triangle_set(mesh.vertices, mesh.indices);
+    const auto statistics = qz::gfx::optimize_mesh(mesh.vertices, 7, mesh.indices);
+
+    check(mesh.vertices.size() % 7 == 0, mesh.name, "vertex data is not whole vertices");
+    const auto vertex_count = mesh.vertices.size() / 7;
+    const auto in_range = std::all_of(mesh.indices.begin(), mesh.indices.end(), [vertex_count](const auto index) {
+        return index < vertex_count;
+    });
+    check(in_range, mesh.name, "index out of range");
+    if (in_range) {
+        check(triangle_set(mesh.vertices, mesh.indices) == before, mesh.name, "triangles differ from the input");
+    }
+    check(statistics.after.acmr < statistics.before.acmr, mesh.name, "ACMR did not improve");
+    check(statistics.after.atvr >= 1.0f, mesh.name, "ATVR below 1");
+    std::printf("%s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", mesh.name,
+        statistics.before.acmr, statistics.after.acmr, statistics.before.atvr, statistics.after.atvr);
+}
+
+int main() {
+    test_mesh(make_grid(64));
+    test_mesh(make_unshared_grid(32));
+    test_mesh(make_shuffled_grid(64));
+    test_mesh(make_sphere(24, 48));
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include <qz/gfx/texture.hpp>
+
+#include "check.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+
+// Builds .dds and .ktx2 files in memory and checks parse_texture locates every level of the valid ones and
+// rejects malformed ones, including those whose offsets would wrap around or point past the end of the file.
+
+using Bytes = std::vector<char>;
+
+constexpr auto dds_header_size = 128u;
+constexpr auto dds_dx10_size = 20u;
+constexpr auto ktx2_header_size = 80u;
+constexpr auto ktx2_level_size = 24u;
+
+template <typename T>
+static void write(Bytes& bytes, const std::size_t offset, const T value) noexcept {
+    if (bytes.size() < offset + sizeof(T)) {
+        bytes.resize(offset + sizeof(T));
+    }
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+static const char* parse(const Bytes& bytes, qz::gfx::TextureLayout& layout) noexcept {
+    return qz::gfx::parse_texture({ bytes.data(), bytes.size() }, layout);
+}
+
+// Header of a 32 bit uncompressed texture with the given channel masks, levels have to be appended.
+static Bytes make_dds_rgb(const std::uint32_t width, const std::uint32_t height, const std::uint32_t mips, const std::uint32_t (&masks)[4]) noexcept {
+    Bytes bytes(dds_header_size);
+    write<std::uint32_t>(bytes, 0, 0x20534444);
+    write<std::uint32_t>(bytes, 4, 124);
+    write<std::uint32_t>(bytes, 12, height);
+    write<std::uint32_t>(bytes, 16, width);
+    write<std::uint32_t>(bytes, 28, mips);
+    write<std::uint32_t>(bytes, 76, 32);
+    write<std::uint32_t>(bytes, 80, 0x40 | 0x1);
+    write<std::uint32_t>(bytes, 88, 32);
+    for (std::uint32_t i = 0; i < 4; ++i) {
+        write<std::uint32_t>(bytes, 92 + i * 4, masks[i]);
+    }
+    return bytes;
+}
+
+static Bytes make_dds_fourcc(const std::uint32_t width, const std::uint32_t height, const std::uint32_t mips, const char (&code)[5]) noexcept {
+    const std::uint32_t none[4] = {};
+    auto bytes = make_dds_rgb(width, height, mips, none);
+    write<std::uint32_t>(bytes, 80, 0x4);
+    write<std::uint32_t>(bytes, 84, code[0] | (code[1] << 8) | (code[2] << 16) | (code[3] << 24));
+    write<std::uint32_t>(bytes, 88, 0);
+    return bytes;
+}
+
+// Level index only, the caller places the levels and fills their ranges.
+static Bytes make_ktx2(const VkFormat format, const std::uint32_t width, const std::uint32_t height, const std::uint32_t levels) noexcept {
+    constexpr std::uint8_t identifier[] = { 0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a };
+    Bytes bytes(ktx2_header_size + levels * ktx2_level_size);
+    std::memcpy(bytes.data(), identifier, sizeof(identifier));
+    write<std::uint32_t>(bytes, 12, format);
+    write<std::uint32_t>(bytes, 16, 1);
+    write<std::uint32_t>(bytes, 20, width);
+    write<std::uint32_t>(bytes, 24, height);
+    write<std::uint32_t>(bytes, 36, 1);
+    write<std::uint32_t>(bytes, 40, levels);
+    return bytes;
+}
+
+static void set_ktx2_level(Bytes& bytes, const std::uint32_t level, const std::uint64_t offset, const std::uint64_t length) noexcept {
+    write<std::uint64_t>(bytes, ktx2_header_size + level * ktx2_level_size, offset);
+    write<std::uint64_t>(bytes, ktx2_header_size + level * ktx2_level_size + 8, length);
+    write<std::uint64_t>(bytes, ktx2_header_size + level * ktx2_level_size + 16, length);
+}
+
+static void expect_levels(const char* test, const Bytes& bytes, const qz::gfx::TextureLayout& layout,
+                          const std::vector<std::size_t>& offsets, const std::vector<std::size_t>& sizes) noexcept {
+    check(layout.level_count == offsets.size(), test, "wrong level count");
+    for (std::size_t i = 0; i < offsets.size() && i < layout.level_count; ++i) {
+        check(layout.levels[i].data == bytes.data() + offsets[i], test, "level at the wrong offset");
+        check(layout.levels[i].size == sizes[i], test, "level of the wrong size");
+    }
+}
+
+static void expect_rejected(const char* test, const Bytes& bytes) noexcept {
+    qz::gfx::TextureLayout layout;
+    const auto error = parse(bytes, layout);
+    check(error != nullptr, test, "malformed file was accepted");
+    if (error) {
+        std::printf("%s: rejected with \"%s\"\n", test, error);
+    }
+}
+
+static void test_dds() noexcept {
+    qz::gfx::TextureLayout layout;
+
+    // 8x4 down to 1x1, stored one after the other.
+    auto rgba = make_dds_rgb(8, 4, 4, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 });
+    rgba.resize(dds_header_size + 128 + 32 + 8 + 4);
+    check(parse(rgba, layout) == nullptr, "dds rgba", "valid file was rejected");
+    check(layout.format == VK_FORMAT_R8G8B8A8_UNORM, "dds rgba", "wrong format");
+    check(layout.width == 8 && layout.height == 4, "dds rgba", "wrong size");
+    expect_levels("dds rgba", rgba, layout, { 128, 256, 288, 296 }, { 128, 32, 8, 4 });
+
+    auto bgra = make_dds_rgb(4, 4, 1, { 0x00ff0000, 0x0000ff00, 0x000000ff, 0xff000000 });
+    bgra.resize(dds_header_size + 64);
+    check(parse(bgra, layout) == nullptr, "dds bgra", "valid file was rejected");
+    check(layout.format == VK_FORMAT_B8G8R8A8_UNORM, "dds bgra", "wrong format");
+
+    // Blocks are 4x4 texels, levels smaller than that still take a whole block.
+    auto bc1 = make_dds_fourcc(16, 16, 5, "DXT1");
+    bc1.resize(dds_header_size + 128 + 32 + 8 + 8 + 8);
+    check(parse(bc1, layout) == nullptr, "dds bc1", "valid file was rejected");
+    check(layout.format == VK_FORMAT_BC1_RGBA_UNORM_BLOCK, "dds bc1", "wrong format");
+    expect_levels("dds bc1", bc1, layout, { 128, 256, 288, 296, 304 }, { 128, 32, 8, 8, 8 });
+
+    auto bc7 = make_dds_fourcc(8, 8, 1, "DX10");
+    write<std::uint32_t>(bc7, dds_header_size, 98);
+    write<std::uint32_t>(bc7, dds_header_size + 4, 3);
+    write<std::uint32_t>(bc7, dds_header_size + 12, 1);
+    bc7.resize(dds_header_size + dds_dx10_size + 64);
+    check(parse(bc7, layout) == nullptr, "dds bc7", "valid file was rejected");
+    check(layout.format == VK_FORMAT_BC7_UNORM_BLOCK, "dds bc7", "wrong format");
+    expect_levels("dds bc7", bc7, layout, { dds_header_size + dds_dx10_size }, { 64 });
+
+    // Padding byte instead of alpha.
+    auto xrgb = make_dds_rgb(4, 4, 1, { 0x00ff0000, 0x0000ff00, 0x000000ff, 0x00000000 });
+    xrgb.resize(dds_header_size + 64);
+    expect_rejected("dds without alpha", xrgb);
+
+    auto swizzled = make_dds_rgb(4, 4, 1, { 0x000000ff, 0x00ff0000, 0x0000ff00, 0xff000000 });
+    swizzled.resize(dds_header_size + 64);
+    expect_rejected("dds with swapped channels", swizzled);
+
+    auto truncated = rgba;
+    truncated.pop_back();
+    expect_rejected("dds truncated level", truncated);
+
+    auto dx10 = make_dds_fourcc(8, 8, 1, "DX10");
+    dx10.resize(dds_header_size + dds_dx10_size - 4);
+    expect_rejected("dds truncated dx10 header", dx10);
+
+    auto array = bc7;
+    write<std::uint32_t>(array, dds_header_size + 12, 6);
+    expect_rejected("dds texture array", array);
+
+    auto volume_dx10 = bc7;
+    write<std::uint32_t>(volume_dx10, dds_header_size + 4, 4);
+    expect_rejected("dds dx10 volume", volume_dx10);
+
+    auto cube_dx10 = bc7;
+    write<std::uint32_t>(cube_dx10, dds_header_size + 8, 0x4);
+    expect_rejected("dds dx10 cube map", cube_dx10);
+
+    auto cube = rgba;
+    write<std::uint32_t>(cube, 112, 0x200 | 0xfc00);
+    expect_rejected("dds cube map", cube);
+
+    auto volume = rgba;
+    write<std::uint32_t>(volume, 24, 2);
+    write<std::uint32_t>(volume, 112, 0x200000);
+    expect_rejected("dds volume", volume);
+
+    auto levels = make_dds_rgb(1 << 20, 1, 21, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 });
+    expect_rejected("dds too many levels", levels);
+
+    // 8x4 has four levels, a fifth would have to be 0x0.
+    auto chain = make_dds_rgb(8, 4, 5, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 });
+    chain.resize(dds_header_size + 128 + 32 + 8 + 4 + 4);
+    expect_rejected("dds levels past the mip chain", chain);
+
+    auto empty = make_dds_rgb(0, 4, 1, { 0x000000ff, 0x0000ff00, 0x00ff0000, 0xff000000 });
+    expect_rejected("dds empty", empty);
+
+    auto header = rgba;
+    header.resize(dds_header_size - 1);
+    expect_rejected("dds truncated header", header);
+}
+
+static void test_ktx2() noexcept {
+    qz::gfx::TextureLayout layout;
+
+    // Smallest level first like most writers store them, the index still starts at mip 0.
+    const auto data = ktx2_header_size + 2 * ktx2_level_size;
+    auto rgba = make_ktx2(VK_FORMAT_R8G8B8A8_SRGB, 2, 2, 2);
+    set_ktx2_level(rgba, 0, data + 4, 16);
+    set_ktx2_level(rgba, 1, data, 4);
+    rgba.resize(data + 20);
+    check(parse(rgba, layout) == nullptr, "ktx2 rgba", "valid file was rejected");
+    check(layout.format == VK_FORMAT_R8G8B8A8_SRGB, "ktx2 rgba", "wrong format");
+    expect_levels("ktx2 rgba", rgba, layout, { data + 4, data }, { 16, 4 });
+
+    // No levels stored past the first one, the loader generates them.
+    auto generated = make_ktx2(VK_FORMAT_R8G8B8A8_UNORM, 4, 4, 0);
+    generated.resize(ktx2_header_size + ktx2_level_size);
+    set_ktx2_level(generated, 0, generated.size(), 64);
+    generated.resize(generated.size() + 64);
+    check(parse(generated, layout) == nullptr, "ktx2 without mips", "valid file was rejected");
+    check(layout.level_count == 1, "ktx2 without mips", "wrong level count");
+
+    auto wrapping = rgba;
+    set_ktx2_level(wrapping, 0, ~std::uint64_t(0) - 7, 16);
+    expect_rejected("ktx2 wrapping offset", wrapping);
+
+    auto past_end = rgba;
+    set_ktx2_level(past_end, 0, past_end.size() - 8, 16);
+    expect_rejected("ktx2 level past the end", past_end);
+
+    auto length = rgba;
+    set_ktx2_level(length, 0, data + 4, 12);
+    expect_rejected("ktx2 wrong level length", length);
+
+    auto index = make_ktx2(VK_FORMAT_R8G8B8A8_UNORM, 256, 256, 9);
+    index.resize(ktx2_header_size + 2 * ktx2_level_size);
+    expect_rejected("ktx2 truncated level index", index);
+
+    auto format = make_ktx2(VK_FORMAT_R16G16B16A16_SFLOAT, 2, 2, 1);
+    set_ktx2_level(format, 0, format.size(), 32);
+    format.resize(format.size() + 32);
+    expect_rejected("ktx2 unsupported format", format);
+
+    auto cube = rgba;
+    write<std::uint32_t>(cube, 36, 6);
+    expect_rejected("ktx2 cube map", cube);
+
+    auto supercompressed = rgba;
+    write<std::uint32_t>(supercompressed, 44, 1);
+    expect_rejected("ktx2 supercompressed", supercompressed);
+}
+
+int main() {
+    test_dds();
+    test_ktx2();
+    expect_rejected("unknown file", Bytes(256, 'x'));
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,255 @@
+#include <qz/gfx/texture_streaming.hpp>
+
+#include "check.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Drives the streaming policy on texture residencies alone: mip tail selection, the level picked for a screen
+// footprint, least recently used eviction, the budget and how long replaced images are kept alive.
+
+constexpr auto tail_size = 128u;
+
+// 8 bit RGBA texture with its whole mip chain, only the level sizes matter.
+static qz::gfx::TextureLayout make_layout(const std::uint32_t width, const std::uint32_t height) noexcept {
+    qz::gfx::TextureLayout layout{};
+    layout.format = VK_FORMAT_R8G8B8A8_UNORM;
+    layout.width = width;
+    layout.height = height;
+    for (auto mip = 0u; (width >> mip) || (height >> mip); ++mip) {
+        const auto level_width = width >> mip ? width >> mip : 1;
+        const auto level_height = height >> mip ? height >> mip : 1;
+        layout.levels[layout.level_count++].size = level_width * level_height * 4;
+    }
+    return layout;
+}
+
+// Texture whose levels from top down finished uploading.
+static qz::gfx::TextureResidency make_resident(const std::uint32_t top, const std::uint64_t last_used) noexcept {
+    auto residency = qz::gfx::make_texture_residency(make_layout(512, 512), tail_size);
+    qz::gfx::finish_texture_upload(residency, top);
+    residency.last_used = last_used;
+    return residency;
+}
+
+static std::size_t total_resident(const std::vector<qz::gfx::TextureResidency>& residencies) noexcept {
+    std::size_t size = 0;
+    for (const auto& each : residencies) {
+        size += each.bytes;
+    }
+    return size;
+}
+
+static bool same_requests(const std::vector<qz::gfx::StreamingRequest>& requests, const std::vector<qz::gfx::StreamingRequest>& expected) noexcept {
+    if (requests.size() != expected.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < requests.size(); ++i) {
+        if (requests[i].texture != expected[i].texture || requests[i].top != expected[i].top) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_residency() noexcept {
+    using namespace qz::gfx;
+
+    const auto square = make_texture_residency(make_layout(512, 512), tail_size);
+    check(square.level_count == 10 && square.size == 512, "residency", "wrong levels");
+    check(square.tail == 2, "residency", "tail should start at the first level of at most 128 texels");
+    check(square.top == square.level_count && square.bytes == 0, "residency", "nothing should be resident yet");
+    check(square.pending && square.incoming == static_cast<std::ptrdiff_t>(resident_size(square, 2)), "residency", "mip tail upload not accounted");
+    check(resident_size(square, 8) == 4 * 4 + 4, "residency", "wrong size of the last levels");
+
+    check(make_texture_residency(make_layout(1024, 128), tail_size).tail == 3, "residency", "tail should follow the longest edge");
+    check(make_texture_residency(make_layout(64, 64), tail_size).tail == 0, "residency", "small textures are all tail");
+
+    auto usage = make_texture_residency(make_layout(512, 512), tail_size);
+    record_texture_usage(usage, 512.0f, 7);
+    check(usage.last_used == 7, "usage", "frame not recorded while loading");
+    check(usage.wanted == usage.tail, "usage", "levels wanted before the tail is resident");
+
+    const auto level = [](const float pixels) noexcept {
+        auto residency = make_resident(2, 0);
+        record_texture_usage(residency, pixels, 1);
+        return residency.wanted;
+    };
+    check(level(512.0f) == 0, "usage", "full size footprint should want mip 0");
+    check(level(4096.0f) == 0, "usage", "magnified footprint should want mip 0");
+    check(level(256.0f) == 1, "usage", "half size footprint should want mip 1");
+    check(level(200.0f) == 1, "usage", "levels should be rounded towards more detail");
+    check(level(1.0f) == 2 && level(0.0f) == 2, "usage", "tiny footprints should stay at the tail");
+
+    auto repeated = make_resident(2, 0);
+    record_texture_usage(repeated, 512.0f, 1);
+    record_texture_usage(repeated, 128.0f, 1);
+    check(repeated.wanted == 0, "usage", "most detailed report of the frame should win");
+}
+
+static void test_eviction_order() noexcept {
+    using namespace qz::gfx;
+
+    std::vector<StreamingRequest> requests;
+    const auto top_size = make_resident(0, 0).level_sizes[0];
+    const auto evict = [&](const std::size_t levels) noexcept {
+        std::vector<TextureResidency> residencies = { make_resident(0, 5), make_resident(0, 2), make_resident(0, 9) };
+        const auto resident = total_resident(residencies);
+        requests.clear();
+        plan_texture_streaming(residencies, resident, 0, resident - std::min(levels * top_size, resident), requests);
+        return residencies;
+    };
+
+    auto residencies = evict(0);
+    check(requests.empty(), "eviction order", "evicted within budget");
+
+    residencies = evict(1);
+    check(same_requests(requests, { { 1, 1 } }), "eviction order", "least recently used texture should go first");
+    check(residencies[1].pending, "eviction order", "evicted texture not marked pending");
+    check(residencies[1].incoming == -static_cast<std::ptrdiff_t>(top_size), "eviction order", "eviction not accounted");
+
+    residencies = evict(2);
+    check(same_requests(requests, { { 1, 1 }, { 0, 1 } }), "eviction order", "second eviction should take the next oldest");
+
+    residencies = evict(3);
+    check(same_requests(requests, { { 1, 1 }, { 0, 1 }, { 2, 1 } }), "eviction order", "every texture should lose a level");
+
+    // Only one level per texture per update, the rest follows once the smaller images are swapped in.
+    residencies = evict(9);
+    check(requests.size() == 3, "eviction order", "texture evicted twice in one update");
+
+    // Pending textures are left alone, their upload already changes what is resident.
+    residencies = { make_resident(0, 1), make_resident(0, 2) };
+    residencies[0].pending = true;
+    requests.clear();
+    plan_texture_streaming(residencies, total_resident(residencies), 0, 0, requests);
+    check(same_requests(requests, { { 1, 1 } }), "eviction order", "pending texture was evicted");
+}
+
+static void test_budget() noexcept {
+    using namespace qz::gfx;
+
+    std::vector<StreamingRequest> requests;
+    // Mip tails stay even when they alone exceed the budget.
+    std::vector<TextureResidency> tails = { make_resident(2, 0), make_resident(2, 1) };
+    plan_texture_streaming(tails, total_resident(tails), 0, 0, requests);
+    check(requests.empty(), "budget", "mip tail was evicted");
+
+    // Three textures want mip 0 and the budget fits exactly one of them, next to the mip tail it replaces.
+    std::vector<TextureResidency> residencies = { make_resident(2, 0), make_resident(2, 0), make_resident(2, 0) };
+    const auto extra = resident_size(residencies[0], 0) - residencies[0].bytes;
+    const auto budget = total_resident(residencies) + resident_size(residencies[0], 0);
+    for (auto& each : residencies) {
+        record_texture_usage(each, 512.0f, 1);
+    }
+    plan_texture_streaming(residencies, total_resident(residencies), 0, budget, requests);
+    check(same_requests(requests, { { 0, 0 } }), "budget", "refinements should stop at the budget");
+    check(residencies[0].incoming == static_cast<std::ptrdiff_t>(extra), "budget", "refinement not accounted");
+    check(residencies[1].wanted == residencies[1].tail, "budget", "wanted level not reset");
+
+    // The pending upload counts against the budget until it is swapped in, and still does afterwards.
+    for (auto& each : residencies) {
+        record_texture_usage(each, 512.0f, 2);
+    }
+    requests.clear();
+    plan_texture_streaming(residencies, total_resident(residencies), 0, budget, requests);
+    check(requests.empty(), "budget", "pending upload not counted");
+
+    finish_texture_upload(residencies[0], 0);
+    check(residencies[0].bytes == resident_size(residencies[0], 0) && !residencies[0].pending, "budget", "upload not swapped in");
+    for (auto& each : residencies) {
+        record_texture_usage(each, 512.0f, 3);
+    }
+    requests.clear();
+    plan_texture_streaming(residencies, total_resident(residencies), 0, budget, requests);
+    check(requests.empty(), "budget", "refined past the budget");
+
+    // Smaller refinements still fit where the full one doesn't.
+    for (auto& each : residencies) {
+        record_texture_usage(each, 256.0f, 4);
+    }
+    requests.clear();
+    plan_texture_streaming(residencies, total_resident(residencies), 0, total_resident(residencies) + resident_size(residencies[1], 1), requests);
+    check(same_requests(requests, { { 1, 1 } }), "budget", "smaller refinement should fit");
+
+    // Replaced images take memory until they retire, refinements wait for them.
+    std::vector<TextureResidency> retiring = { make_resident(2, 0) };
+    const auto fits = total_resident(retiring) + resident_size(retiring[0], 0);
+    record_texture_usage(retiring[0], 512.0f, 1);
+    requests.clear();
+    plan_texture_streaming(retiring, total_resident(retiring), 1, fits, requests);
+    check(requests.empty(), "budget", "retiring image not counted");
+    record_texture_usage(retiring[0], 512.0f, 2);
+    plan_texture_streaming(retiring, total_resident(retiring), 0, fits, requests);
+    check(same_requests(requests, { { 0, 0 } }), "budget", "refinement should fit once the image retired");
+
+    // Over budget, evictions make room before anything is refined.
+    std::vector<TextureResidency> mixed = { make_resident(0, 1), make_resident(2, 2) };
+    record_texture_usage(mixed[1], 512.0f, 2);
+    requests.clear();
+    plan_texture_streaming(mixed, total_resident(mixed), 0, total_resident(mixed) - 1, requests);
+    check(same_requests(requests, { { 0, 1 } }), "budget", "refined while over budget");
+
+    // The evicted level stays allocated until the old image retires, it makes no room for refinements before that.
+    const auto level = mixed[0].level_sizes[0];
+    const auto refinement = resident_size(mixed[1], 1);
+    record_texture_usage(mixed[1], 256.0f, 3);
+    requests.clear();
+    plan_texture_streaming(mixed, total_resident(mixed), 0, total_resident(mixed) - level + refinement, requests);
+    check(requests.empty(), "budget", "refined into memory the evicted image still holds");
+
+    const auto retired = mixed[0].bytes;
+    finish_texture_upload(mixed[0], 1);
+    record_texture_usage(mixed[1], 256.0f, 4);
+    plan_texture_streaming(mixed, total_resident(mixed), retired, total_resident(mixed) + refinement, requests);
+    check(requests.empty(), "budget", "refined before the evicted image retired");
+    record_texture_usage(mixed[1], 256.0f, 5);
+    plan_texture_streaming(mixed, total_resident(mixed), 0, total_resident(mixed) + refinement, requests);
+    check(same_requests(requests, { { 1, 1 } }), "budget", "refinement should fit once the evicted image retired");
+}
+
+static void test_retire_delay() noexcept {
+    using namespace qz::gfx;
+
+    // Images are told apart by their width.
+    const auto image = [](const std::uint32_t id) noexcept {
+        Image result{};
+        result.width = id;
+        return result;
+    };
+
+    RetireQueue queue;
+    queue.push(1, image(1), 100);
+    queue.push(2, image(2), 20);
+    queue.push(2, image(3), 3);
+    check(queue.bytes() == 123, "retire delay", "retiring bytes not counted");
+
+    std::vector<Image> expired;
+    for (std::uint64_t frame = 1; frame < 1 + texture_retire_delay; ++frame) {
+        queue.collect(frame, expired);
+    }
+    check(expired.empty(), "retire delay", "image freed while frames in flight may sample it");
+
+    queue.collect(1 + texture_retire_delay, expired);
+    check(expired.size() == 1 && expired[0].width == 1, "retire delay", "image not freed once its delay passed");
+    check(queue.bytes() == 23, "retire delay", "freed image still counted");
+
+    expired.clear();
+    queue.collect(10 + texture_retire_delay, expired);
+    check(expired.size() == 2 && expired[0].width == 2 && expired[1].width == 3, "retire delay", "images freed out of order");
+    check(queue.size() == 0 && queue.bytes() == 0, "retire delay", "queue not empty");
+
+    expired.clear();
+    queue.push(100, image(4), 4);
+    queue.drain(expired);
+    check(expired.size() == 1 && expired[0].width == 4 && queue.size() == 0 && queue.bytes() == 0, "retire delay", "drain kept images");
+}
+
+int main() {
+    test_residency();
+    test_eviction_order();
+    test_budget();
+    test_retire_delay();
+    return failures == 0 ? 0 : 1;
+}
\ No newline at end of file
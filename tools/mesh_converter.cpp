@@ -0,0 +1,195 @@
+#include <qz/gfx/mesh_simplifier.hpp>
+#include <qz/gfx/mesh_optimizer.hpp>
+#include <qz/gfx/vertex_format.hpp>
+#include <qz/gfx/mesh_format.hpp>
+
+#include <unordered_map>
+#include <cstdlib>
+#include <cstring>
+#include <cstdio>
+#include <vector>
+#include <string>
+#include <array>
+
+// Converts a Wavefront OBJ into a .qzm file: positions, then normals and texture coordinates when present,
+// packed as snorm8x4 and half2. Polygons are triangulated as fans, vertices sharing every attribute are merged
+// and the result is reordered for vertex cache, overdraw and fetch locality. Levels of detail are appended
+// to the index section, 4 unless given.
+// Usage: MeshConverter <input.obj> <output.qzm> [lods]
+
+struct Corner {
+    int position;
+    int uv;
+    int normal;
+};
+
+static int resolve(const int index, const std::size_t count) noexcept {
+    // OBJ indices are 1-based, negative ones are relative to the end of the list.
+    return index < 0 ? static_cast<int>(count) + index : index - 1;
+}
+
+static Corner parse_corner(const char* token, const std::array<std::size_t, 3>& counts) noexcept {
+    Corner corner{ -1, -1, -1 };
+    int values[3] = { 0, 0, 0 };
+    for (int i = 0; i < 3 && *token; ++i) {
+        if (*token != '/') {
+            values[i] = std::atoi(token);
+        }
+        while (*token && *token != '/') {
+            ++token;
+        }
+        if (*token == '/') {
+            ++token;
+        }
+    }
+    corner.position = values[0] ? resolve(values[0], counts[0]) : -1;
+    corner.uv = values[1] ? resolve(values[1], counts[1]) : -1;
+    corner.normal = values[2] ? resolve(values[2], counts[2]) : -1;
+    return corner;
+}
+
+int main(int argc, char** argv) {
+    if (argc != 3 && argc != 4) {
+        std::fprintf(stderr, "Usage: %s <input.obj> <output.qzm> [lods]\n", argv[0]);
+        return 1;
+    }
+
+    auto input = std::fopen(argv[1], "r");
+    if (!input) {
+        std::fprintf(stderr, "Failed to open %s\n", argv[1]);
+        return 1;
+    }
+
+    std::vector<std::array<float, 3>> positions;
+    std::vector<std::array<float, 3>> normals;
+    std::vector<std::array<float, 2>> uvs;
+    std::vector<Corner> corners;
+    char line[1024];
+    while (std::fgets(line, sizeof line, input)) {
+        if (std::strncmp(line, "v ", 2) == 0) {
+            auto& each = positions.emplace_back();
+            std::sscanf(line + 2, "%f %f %f", &each[0], &each[1], &each[2]);
+        } else if (std::strncmp(line, "vn ", 3) == 0) {
+            auto& each = normals.emplace_back();
+            std::sscanf(line + 3, "%f %f %f", &each[0], &each[1], &each[2]);
+        } else if (std::strncmp(line, "vt ", 3) == 0) {
+            auto& each = uvs.emplace_back();
+            std::sscanf(line + 3, "%f %f", &each[0], &each[1]);
+        } else if (std::strncmp(line, "f ", 2) == 0) {
+            const std::array<std::size_t, 3> counts = { positions.size(), uvs.size(), normals.size() };
+            std::vector<Corner> polygon;
+            for (auto token = std::strtok(line + 2, " \t\r\n"); token; token = std::strtok(nullptr, " \t\r\n")) {
+                polygon.emplace_back(parse_corner(token, counts));
+            }
+            for (std::size_t i = 2; i < polygon.size(); ++i) {
+                corners.insert(corners.end(), { polygon[0], polygon[i - 1], polygon[i] });
+            }
+        }
+    }
+    std::fclose(input);
+    // The loader rejects meshes without triangles, so must the converter.
+    if (corners.empty()) {
+        std::fprintf(stderr, "%s has no faces\n", argv[1]);
+        return 1;
+    }
+
+    const auto has_uvs = !uvs.empty();
+    const auto has_normals = !normals.empty();
+    qz::gfx::MeshFileHeader header{};
+    header.magic = qz::gfx::mesh_file_magic;
+    header.version = qz::gfx::mesh_file_version;
+    std::vector<qz::gfx::VertexAttribute> attributes = { qz::gfx::VertexAttribute::vec3 };
+    if (has_normals) {
+        attributes.emplace_back(qz::gfx::VertexAttribute::snorm8x4);
+    }
+    if (has_uvs) {
+        attributes.emplace_back(qz::gfx::VertexAttribute::half2);
+    }
+    for (const auto each : attributes) {
+        header.attributes[header.attribute_count++] = static_cast<std::uint32_t>(each);
+    }
+    header.index_size = sizeof(std::uint32_t);
+
+    std::vector<float> vertices;
+    std::vector<std::uint32_t> indices;
+    std::unordered_map<std::string, std::uint32_t> unique;
+    indices.reserve(corners.size());
+    for (const auto& each : corners) {
+        if (each.position < 0 || each.position >= static_cast<int>(positions.size())) {
+            std::fprintf(stderr, "Face references a missing position\n");
+            return 1;
+        }
+        // Normals and texture coordinates are optional per corner, negative indices mean there is none.
+        if (each.normal >= static_cast<int>(normals.size())) {
+            std::fprintf(stderr, "Face references a missing normal\n");
+            return 1;
+        }
+        if (each.uv >= static_cast<int>(uvs.size())) {
+            std::fprintf(stderr, "Face references a missing texture coordinate\n");
+            return 1;
+        }
+        const auto key = std::to_string(each.position) + '/' + std::to_string(each.uv) + '/' + std::to_string(each.normal);
+        const auto [it, inserted] = unique.try_emplace(key, header.vertex_count);
+        if (inserted) {
+            const auto& position = positions[each.position];
+            vertices.insert(vertices.end(), position.begin(), position.end());
+            if (has_normals) {
+                const auto normal = each.normal >= 0 ? normals[each.normal] : std::array<float, 3>{};
+                vertices.insert(vertices.end(), { normal[0], normal[1], normal[2], 0.0f });
+            }
+            if (has_uvs) {
+                const auto uv = each.uv >= 0 ? uvs[each.uv] : std::array<float, 2>{};
+                vertices.insert(vertices.end(), uv.begin(), uv.end());
+            }
+            ++header.vertex_count;
+        }
+        indices.emplace_back(it->second);
+    }
+    const auto optimization = qz::gfx::optimize_mesh(vertices, qz::gfx::vertex_components(attributes), indices);
+    header.vertex_count = vertices.size() / qz::gfx::vertex_components(attributes);
+    const auto lods = qz::gfx::generate_lods(vertices, qz::gfx::vertex_components(attributes), indices, argc == 4 ? std::atoi(argv[3]) : 4);
+    std::vector<std::uint32_t> clusters;
+    for (std::size_t i = 0; i < lods.size(); ++i) {
+        header.lods[header.lod_count++] = lods[i];
+        if (i != 0) {
+            qz::gfx::optimize_vertex_cache(std::span(indices).subspan(lods[i].first_index, lods[i].index_count), header.vertex_count, clusters);
+        }
+    }
+    header.index_count = indices.size();
+    header.bounds = qz::gfx::compute_bounds(vertices, qz::gfx::vertex_components(attributes));
+    // Meshes addressable with 16 bit indices are stored narrowed, halving the index section.
+    if (header.vertex_count <= 65536) {
+        header.index_size = sizeof(std::uint16_t);
+    }
+
+    const auto align = [](const std::uint64_t value) noexcept {
+        return (value + qz::gfx::mesh_file_alignment - 1) & ~(qz::gfx::mesh_file_alignment - 1);
+    };
+    const auto vertices_size = static_cast<std::size_t>(header.vertex_count) * qz::gfx::vertex_stride(attributes);
+    const auto indices_size = indices.size() * header.index_size;
+    header.vertex_offset = align(sizeof header);
+    header.index_offset = align(header.vertex_offset + vertices_size);
+
+    std::vector<char> file(header.index_offset + indices_size);
+    std::memcpy(file.data(), &header, sizeof header);
+    qz::gfx::pack_vertices(vertices, attributes, file.data() + header.vertex_offset);
+    if (header.index_size == sizeof(std::uint16_t)) {
+        const std::vector<std::uint16_t> narrow(indices.begin(), indices.end());
+        std::memcpy(file.data() + header.index_offset, narrow.data(), indices_size);
+    } else {
+        std::memcpy(file.data() + header.index_offset, indices.data(), indices_size);
+    }
+
+    auto output = std::fopen(argv[2], "wb");
+    if (!output || std::fwrite(file.data(), 1, file.size(), output) != file.size()) {
+        std::fprintf(stderr, "Failed to write %s\n", argv[2]);
+        return 1;
+    }
+    std::fclose(output);
+    std::printf("%s: %u vertices, %u indices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", argv[2], header.vertex_count, header.index_count,
+        optimization.before.acmr, optimization.after.acmr, optimization.before.atvr, optimization.after.atvr);
+    for (std::uint32_t i = 0; i < header.lod_count; ++i) {
+        std::printf("  lod %u: %u triangles, error %f\n", i, header.lods[i].index_count / 3, header.lods[i].error);
+    }
+    return 0;
+}
\ No newline at end of file